@@ -0,0 +1,528 @@
+﻿#ifndef ARCHETYPE_STORAGE_HPP
+#define ARCHETYPE_STORAGE_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <new>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+
+#include "ComponentTypeRegistry.hpp"
+
+
+
+// 前方宣言
+class GameObject;
+class Archetype;
+
+
+// データコンポーネント(ComponentBaseを継承しない型)の型情報
+// アーキタイプ間でオブジェクトを移動するとき、型を知らずに移動・破棄できるよう関数ポインタで持つ
+struct DataComponentInfo
+{
+    ComponentTypeID id;
+    std::size_t size;
+    std::size_t align;
+
+    // a_pSrc の値を a_pDst へムーブ構築し、a_pSrc を破棄する
+    void (*relocate)(void* a_pDst,void* a_pSrc);
+
+    // a_p の値を破棄する
+    void (*destroy)(void* a_p);
+
+    // 型から型情報を取得する
+    template<typename DataType>
+    static const DataComponentInfo& Get()
+    {
+        static const DataComponentInfo s_info =
+        {
+            ComponentTypeRegistry::GetID<DataType>(),
+            sizeof(DataType),
+            alignof(DataType),
+            [](void* a_pDst,void* a_pSrc)
+            {
+                DataType* pSrc = static_cast<DataType*>(a_pSrc);
+                new(a_pDst) DataType(std::move(*pSrc));
+                pSrc->~DataType();
+            },
+            [](void* a_p)
+            {
+                static_cast<DataType*>(a_p)->~DataType();
+            }
+        };
+        return s_info;
+    }
+};
+
+
+// オブジェクトのデータがどのアーキタイプの何行目に格納されているか
+// GameObjectが持ち、アーキタイプ側からは行の移動時に書き換えられる
+struct ArchetypeLocation
+{
+    Archetype* pArchetype = nullptr;
+    std::size_t row = 0;
+    GameObject* pOwner = nullptr;
+};
+
+
+// 同じデータコンポーネントの組み合わせを持つオブジェクトをまとめて格納するクラス
+// 固定サイズのチャンクごとに、型ごとの連続した配列(SoA)として並べて持つ
+class Archetype
+{
+public:
+    // 1チャンクのバイト数
+    static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+
+    // チャンク先頭のアライメント (これより大きいアライメントの型は格納できない)
+    static constexpr std::size_t CHUNK_ALIGN = 64;
+
+    // 引数の型情報はIDの昇順に並んでいること
+    explicit Archetype(std::vector<const DataComponentInfo*> a_vInfos)
+        : m_vInfos(std::move(a_vInfos))
+    {
+        for(const DataComponentInfo* pInfo : m_vInfos)
+        {
+            m_vTypeIDs.push_back(pInfo->id);
+        }
+
+        // 1行あたりのバイト数からチャンクに収まる行数を求め、収まらなければ減らしていく
+        std::size_t rowBytes = sizeof(ArchetypeLocation*);
+        for(const DataComponentInfo* pInfo : m_vInfos)
+        {
+            rowBytes += pInfo->size;
+        }
+        m_chunkCapacity = std::max<std::size_t>(CHUNK_SIZE / rowBytes,1);
+        while(m_chunkCapacity > 1 && ComputeLayout(m_chunkCapacity) > CHUNK_SIZE)
+        {
+            --m_chunkCapacity;
+        }
+
+        // 1行でもCHUNK_SIZEを超える大きな型の場合はチャンクを大きくする
+        m_chunkBytes = std::max(ComputeLayout(m_chunkCapacity),CHUNK_SIZE);
+    }
+
+    ~Archetype()
+    {
+        // 残っている行のデータを全て破棄する
+        for(std::size_t row = 0; row < m_count; ++row)
+        {
+            for(std::size_t col = 0; col < m_vInfos.size(); ++col)
+            {
+                m_vInfos[col]->destroy(GetElement(row,col));
+            }
+        }
+        for(std::byte* pChunk : m_vChunks)
+        {
+            ::operator delete(pChunk,std::align_val_t(CHUNK_ALIGN));
+        }
+    }
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    // このアーキタイプが持つ型のID (昇順)
+    const std::vector<ComponentTypeID>& GetTypeIDs() const
+    {
+        return m_vTypeIDs;
+    }
+
+    // 引数のIDの型が何列目に格納されているか (無ければ -1)
+    int FindColumn(ComponentTypeID a_id) const
+    {
+        auto itr = std::lower_bound(m_vTypeIDs.begin(),m_vTypeIDs.end(),a_id);
+        if(itr == m_vTypeIDs.end() || *itr != a_id)
+        {
+            return -1;
+        }
+        return static_cast<int>(itr - m_vTypeIDs.begin());
+    }
+
+    // 格納している行(オブジェクト)の数
+    std::size_t GetCount() const
+    {
+        return m_count;
+    }
+
+    // チャンクの数
+    std::size_t GetChunkCount() const
+    {
+        return m_vChunks.size();
+    }
+
+    // 引数のチャンクに格納されている行の数
+    std::size_t GetChunkRowCount(std::size_t a_chunk) const
+    {
+        return std::min(m_count - a_chunk * m_chunkCapacity,m_chunkCapacity);
+    }
+
+    // 引数のチャンクの引数の列の先頭アドレス (チャンク内では型の配列として連続している)
+    void* GetColumnData(std::size_t a_chunk,std::size_t a_column) const
+    {
+        return m_vChunks[a_chunk] + m_vColumnOffsets[a_column];
+    }
+
+    // 引数の行・列の要素のアドレス
+    void* GetElement(std::size_t a_row,std::size_t a_column) const
+    {
+        std::size_t chunk = a_row / m_chunkCapacity;
+        std::size_t index = a_row % m_chunkCapacity;
+        return static_cast<std::byte*>(GetColumnData(chunk,a_column)) + index * m_vInfos[a_column]->size;
+    }
+
+private:
+    friend class ArchetypeStorage;
+
+    // 引数の行数でチャンクを並べたときに必要なバイト数を求め、各列の開始位置を決める
+    std::size_t ComputeLayout(std::size_t a_capacity)
+    {
+        // チャンクの先頭には各行の持ち主の位置情報へのポインタを並べる
+        std::size_t offset = sizeof(ArchetypeLocation*) * a_capacity;
+
+        m_vColumnOffsets.clear();
+        for(const DataComponentInfo* pInfo : m_vInfos)
+        {
+            offset = (offset + pInfo->align - 1) / pInfo->align * pInfo->align;
+            m_vColumnOffsets.push_back(offset);
+            offset += pInfo->size * a_capacity;
+        }
+        return (offset + CHUNK_ALIGN - 1) / CHUNK_ALIGN * CHUNK_ALIGN;
+    }
+
+    // 引数の行の持ち主の位置情報
+    ArchetypeLocation*& OwnerAt(std::size_t a_row)
+    {
+        std::size_t chunk = a_row / m_chunkCapacity;
+        std::size_t index = a_row % m_chunkCapacity;
+        return reinterpret_cast<ArchetypeLocation**>(m_vChunks[chunk])[index];
+    }
+
+    // 末尾に行を確保してその行番号を返す (各列の値は呼び出し側で構築すること)
+    std::size_t AllocateRow(ArchetypeLocation* a_pLocation)
+    {
+        if(m_count == m_vChunks.size() * m_chunkCapacity)
+        {
+            m_vChunks.push_back(static_cast<std::byte*>(::operator new(m_chunkBytes,std::align_val_t(CHUNK_ALIGN))));
+        }
+
+        std::size_t row = m_count++;
+        OwnerAt(row) = a_pLocation;
+        return row;
+    }
+
+    // 引数の行を削除する (各列の値は呼び出し側で移動または破棄済みであること)
+    // 末尾の行を空いた行へ移動して詰めるため、移動した行の持ち主の位置情報も書き換える
+    void RemoveRow(std::size_t a_row)
+    {
+        std::size_t last = m_count - 1;
+        if(a_row != last)
+        {
+            for(std::size_t col = 0; col < m_vInfos.size(); ++col)
+            {
+                m_vInfos[col]->relocate(GetElement(a_row,col),GetElement(last,col));
+            }
+            ArchetypeLocation* pMoved = OwnerAt(last);
+            OwnerAt(a_row) = pMoved;
+            pMoved->row = a_row;
+        }
+        --m_count;
+
+        // 空になった末尾のチャンクを解放する
+        if(m_count == (m_vChunks.size() - 1) * m_chunkCapacity)
+        {
+            ::operator delete(m_vChunks.back(),std::align_val_t(CHUNK_ALIGN));
+            m_vChunks.pop_back();
+        }
+    }
+
+private:
+    // 格納する型の情報とID (どちらもIDの昇順)
+    std::vector<const DataComponentInfo*> m_vInfos;
+    std::vector<ComponentTypeID> m_vTypeIDs;
+
+    // チャンク先頭から各列の配列までのオフセット
+    std::vector<std::size_t> m_vColumnOffsets;
+
+    // 1チャンクに格納できる行数とチャンクのバイト数
+    std::size_t m_chunkCapacity = 1;
+    std::size_t m_chunkBytes = CHUNK_SIZE;
+
+    // チャンクの先頭アドレス
+    std::vector<std::byte*> m_vChunks;
+
+    // 格納している行の数
+    std::size_t m_count = 0;
+
+    // 型を1つ追加/削除したときの移動先アーキタイプのキャッシュ
+    std::unordered_map<ComponentTypeID,Archetype*> m_umAddEdges;
+    std::unordered_map<ComponentTypeID,Archetype*> m_umRemoveEdges;
+};
+
+
+// データコンポーネントをアーキタイプごとにまとめて格納するクラス
+// ObjectManagerが所有し、GameObjectのAdd/Get/RemoveComponentから使われる
+class ArchetypeStorage
+{
+public:
+    // データコンポーネントを追加する
+    // 既に同じ型を持っていれば値を作り直し、持っていなければ型を1つ増やしたアーキタイプへ移動する
+    template<typename DataType,typename...ArgTypes>
+    DataType* Add(ArchetypeLocation& a_location,ArgTypes&&... a_args)
+    {
+        static_assert(alignof(DataType) <= Archetype::CHUNK_ALIGN,"DataType alignment is too large");
+
+        const DataComponentInfo& info = DataComponentInfo::Get<DataType>();
+
+        // 移動の途中で例外が出ないよう、先に値を作っておく
+        DataType value(std::forward<ArgTypes>(a_args)...);
+
+        Archetype* pSrc = a_location.pArchetype;
+        if(pSrc != nullptr)
+        {
+            int col = pSrc->FindColumn(info.id);
+            if(col >= 0)
+            {
+                DataType* pExisting = static_cast<DataType*>(pSrc->GetElement(a_location.row,col));
+                pExisting->~DataType();
+                return new(pExisting) DataType(std::move(value));
+            }
+        }
+
+        Archetype* pDst = GetAddTarget(pSrc,info);
+        MoveRow(a_location,pDst);
+
+        void* pElement = pDst->GetElement(a_location.row,pDst->FindColumn(info.id));
+        return new(pElement) DataType(std::move(value));
+    }
+
+    // 引数のIDのデータコンポーネントを削除し、型を1つ減らしたアーキタイプへ移動する
+    void Remove(ArchetypeLocation& a_location,ComponentTypeID a_id)
+    {
+        Archetype* pSrc = a_location.pArchetype;
+        if(pSrc == nullptr || pSrc->FindColumn(a_id) < 0)
+        {
+            return;
+        }
+
+        // 最後の1つを削除するならどのアーキタイプにも属さなくなる
+        if(pSrc->GetTypeIDs().size() == 1)
+        {
+            RemoveAll(a_location);
+            return;
+        }
+
+        MoveRow(a_location,GetRemoveTarget(pSrc,a_id));
+    }
+
+    template<typename DataType>
+    void Remove(ArchetypeLocation& a_location)
+    {
+        Remove(a_location,ComponentTypeRegistry::GetID<DataType>());
+    }
+
+    // データコンポーネントを取得する (持っていなければnullptr)
+    // アーキタイプ間の移動で場所が変わるため、返したポインタを保持し続けないこと
+    template<typename DataType>
+    DataType* Get(const ArchetypeLocation& a_location) const
+    {
+        Archetype* pArchetype = a_location.pArchetype;
+        if(pArchetype == nullptr)
+        {
+            return nullptr;
+        }
+
+        int col = pArchetype->FindColumn(ComponentTypeRegistry::GetID<DataType>());
+        if(col < 0)
+        {
+            return nullptr;
+        }
+        return static_cast<DataType*>(pArchetype->GetElement(a_location.row,col));
+    }
+
+    // 引数のIDのデータコンポーネントを持っているか
+    bool Has(const ArchetypeLocation& a_location,ComponentTypeID a_id) const
+    {
+        return a_location.pArchetype != nullptr && a_location.pArchetype->FindColumn(a_id) >= 0;
+    }
+
+    // 全てのデータコンポーネントを破棄し、どのアーキタイプにも属さない状態にする
+    void RemoveAll(ArchetypeLocation& a_location)
+    {
+        Archetype* pSrc = a_location.pArchetype;
+        if(pSrc == nullptr)
+        {
+            return;
+        }
+
+        for(std::size_t col = 0; col < pSrc->m_vInfos.size(); ++col)
+        {
+            pSrc->m_vInfos[col]->destroy(pSrc->GetElement(a_location.row,col));
+        }
+        pSrc->RemoveRow(a_location.row);
+
+        a_location.pArchetype = nullptr;
+        a_location.row = 0;
+    }
+
+    // 引数の型を全て持つオブジェクトのデータに対して関数を呼ぶ
+    // チャンク内の型ごとの配列を先頭から順に辿るため、キャッシュ効率が良い
+    // 関数の中でデータコンポーネントの追加/削除をしないこと
+    template<typename...DataTypes,typename Func>
+    void ForEach(Func&& a_func)
+    {
+        static_assert(sizeof...(DataTypes) > 0,"ForEach needs at least one DataType");
+
+        for(auto& pair : m_mapArchetypes)
+        {
+            Archetype& archetype = *pair.second;
+            if(archetype.GetCount() == 0)
+            {
+                continue;
+            }
+
+            // 引数の型が全て含まれているアーキタイプだけを処理する
+            int cols[] = { archetype.FindColumn(ComponentTypeRegistry::GetID<DataTypes>())... };
+            if(std::any_of(std::begin(cols),std::end(cols),[](int a_col) { return a_col < 0; }))
+            {
+                continue;
+            }
+
+            for(std::size_t chunk = 0; chunk < archetype.GetChunkCount(); ++chunk)
+            {
+                ForEachInChunk<DataTypes...>(archetype,chunk,cols,a_func,std::index_sequence_for<DataTypes...>());
+            }
+        }
+    }
+
+    // 作成済みのアーキタイプの数
+    std::size_t GetArchetypeCount() const
+    {
+        return m_mapArchetypes.size();
+    }
+
+private:
+    template<typename...DataTypes,typename Func,std::size_t...Indices>
+    static void ForEachInChunk(Archetype& a_archetype,std::size_t a_chunk,const int* a_cols,Func& a_func,std::index_sequence<Indices...>)
+    {
+        std::tuple<DataTypes*...> columns(static_cast<DataTypes*>(a_archetype.GetColumnData(a_chunk,a_cols[Indices]))...);
+
+        std::size_t count = a_archetype.GetChunkRowCount(a_chunk);
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            a_func(std::get<Indices>(columns)[i]...);
+        }
+    }
+
+    // 型の組み合わせからアーキタイプを取得する (無ければ作成する)
+    Archetype* GetOrCreateArchetype(std::vector<const DataComponentInfo*> a_vInfos)
+    {
+        std::vector<ComponentTypeID> key;
+        for(const DataComponentInfo* pInfo : a_vInfos)
+        {
+            key.push_back(pInfo->id);
+        }
+
+        auto itr = m_mapArchetypes.find(key);
+        if(itr != m_mapArchetypes.end())
+        {
+            return itr->second.get();
+        }
+
+        std::unique_ptr<Archetype> upArchetype = std::make_unique<Archetype>(std::move(a_vInfos));
+        Archetype* pArchetype = upArchetype.get();
+        m_mapArchetypes.emplace(std::move(key),std::move(upArchetype));
+        return pArchetype;
+    }
+
+    // 引数のアーキタイプに型を1つ追加したアーキタイプを取得する
+    Archetype* GetAddTarget(Archetype* a_pSrc,const DataComponentInfo& a_info)
+    {
+        if(a_pSrc == nullptr)
+        {
+            return GetOrCreateArchetype({ &a_info });
+        }
+
+        auto itr = a_pSrc->m_umAddEdges.find(a_info.id);
+        if(itr != a_pSrc->m_umAddEdges.end())
+        {
+            return itr->second;
+        }
+
+        std::vector<const DataComponentInfo*> vInfos = a_pSrc->m_vInfos;
+        auto insertItr = std::lower_bound(vInfos.begin(),vInfos.end(),a_info.id,
+            [](const DataComponentInfo* a_pInfo,ComponentTypeID a_key) { return a_pInfo->id < a_key; });
+        vInfos.insert(insertItr,&a_info);
+
+        Archetype* pDst = GetOrCreateArchetype(std::move(vInfos));
+        a_pSrc->m_umAddEdges[a_info.id] = pDst;
+        pDst->m_umRemoveEdges[a_info.id] = a_pSrc;
+        return pDst;
+    }
+
+    // 引数のアーキタイプから型を1つ削除したアーキタイプを取得する
+    Archetype* GetRemoveTarget(Archetype* a_pSrc,ComponentTypeID a_id)
+    {
+        auto itr = a_pSrc->m_umRemoveEdges.find(a_id);
+        if(itr != a_pSrc->m_umRemoveEdges.end())
+        {
+            return itr->second;
+        }
+
+        std::vector<const DataComponentInfo*> vInfos;
+        for(const DataComponentInfo* pInfo : a_pSrc->m_vInfos)
+        {
+            if(pInfo->id != a_id)
+            {
+                vInfos.push_back(pInfo);
+            }
+        }
+
+        Archetype* pDst = GetOrCreateArchetype(std::move(vInfos));
+        a_pSrc->m_umRemoveEdges[a_id] = pDst;
+        pDst->m_umAddEdges[a_id] = a_pSrc;
+        return pDst;
+    }
+
+    // オブジェクトの行を別のアーキタイプへ移動する
+    // 共通する型の値はムーブし、移動先に無い型の値は破棄する
+    // 移動元に無い型の値は構築されないので、呼び出し側で構築すること
+    void MoveRow(ArchetypeLocation& a_location,Archetype* a_pDst)
+    {
+        Archetype* pSrc = a_location.pArchetype;
+        std::size_t dstRow = a_pDst->AllocateRow(&a_location);
+
+        if(pSrc != nullptr)
+        {
+            std::size_t srcRow = a_location.row;
+            for(std::size_t srcCol = 0; srcCol < pSrc->m_vInfos.size(); ++srcCol)
+            {
+                const DataComponentInfo* pInfo = pSrc->m_vInfos[srcCol];
+                void* pSrcElement = pSrc->GetElement(srcRow,srcCol);
+
+                int dstCol = a_pDst->FindColumn(pInfo->id);
+                if(dstCol >= 0)
+                {
+                    pInfo->relocate(a_pDst->GetElement(dstRow,dstCol),pSrcElement);
+                }
+                else
+                {
+                    pInfo->destroy(pSrcElement);
+                }
+            }
+            pSrc->RemoveRow(srcRow);
+        }
+
+        a_location.pArchetype = a_pDst;
+        a_location.row = dstRow;
+    }
+
+private:
+    // 型の組み合わせ(IDの昇順)とアーキタイプを紐づけて格納するコンテナ
+    std::map<std::vector<ComponentTypeID>,std::unique_ptr<Archetype>> m_mapArchetypes;
+};
+
+#endif // ARCHETYPE_STORAGE_HPP
@@ -0,0 +1,180 @@
+﻿#ifndef BULK_ALLOCATOR_HPP
+#define BULK_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+
+
+// 大きなメモリの塊から順に切り出すだけのアリーナ
+// 個別の解放は行わず、切り出したメモリが全て返却されたときにまとめて解放する
+// 同時に生成して同時に破棄されることの多いオブジェクト(敵の群れなど)をまとめて確保するために使う
+// 1つでも生き残っているとアリーナ全体が解放されないので、寿命のばらばらなものには使わないこと
+class BulkArena
+{
+public:
+    // 引数の大きさの塊を確保したアリーナを作る (参照カウント1で返すので、使い終わったら Release を呼ぶ)
+    static BulkArena* Create(std::size_t a_blockSize)
+    {
+        return new BulkArena(a_blockSize);
+    }
+
+    BulkArena(const BulkArena&) = delete;
+    BulkArena& operator=(const BulkArena&) = delete;
+
+    // メモリを切り出す (塊が足りなければ同じ大きさの塊を追加で確保する)
+    // 割り当てるスレッドは1つだけであること (解放は任意のスレッドから行われても良い)
+    void* Allocate(std::size_t a_size,std::size_t a_align)
+    {
+        void* p = AllocateFromBlock(m_pHead,a_size,a_align);
+        if(p == nullptr)
+        {
+            AddBlock(std::max(m_blockSize,a_size + a_align));
+            p = AllocateFromBlock(m_pHead,a_size,a_align);
+        }
+        return p;
+    }
+
+    // 確保した塊の数
+    std::size_t GetBlockCount() const
+    {
+        std::size_t count = 0;
+        for(const Block* pBlock = m_pHead; pBlock != nullptr; pBlock = pBlock->pNext)
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    void AddRef()
+    {
+        m_refCount.fetch_add(1,std::memory_order_relaxed);
+    }
+
+    // 参照カウントが0になったら、全ての塊を解放してアリーナも破棄する
+    // 切り出したメモリが全て返却され、作成した側も Release を呼んだときに0になる
+    void Release()
+    {
+        if(m_refCount.fetch_sub(1,std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+private:
+    // 塊の先頭に置く情報 (この後ろに切り出すメモリが続く)
+    struct Block
+    {
+        Block* pNext;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    explicit BulkArena(std::size_t a_blockSize)
+        : m_blockSize(a_blockSize)
+    {
+        AddBlock(a_blockSize);
+    }
+
+    ~BulkArena()
+    {
+        while(m_pHead != nullptr)
+        {
+            Block* pNext = m_pHead->pNext;
+            ::operator delete(m_pHead);
+            m_pHead = pNext;
+        }
+    }
+
+    void AddBlock(std::size_t a_size)
+    {
+        Block* pBlock = static_cast<Block*>(::operator new(sizeof(Block) + a_size));
+        pBlock->pNext = m_pHead;
+        pBlock->size = a_size;
+        pBlock->used = 0;
+        m_pHead = pBlock;
+    }
+
+    static void* AllocateFromBlock(Block* a_pBlock,std::size_t a_size,std::size_t a_align)
+    {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(a_pBlock + 1);
+        std::uintptr_t top = (base + a_pBlock->used + a_align - 1) & ~static_cast<std::uintptr_t>(a_align - 1);
+        if(top + a_size > base + a_pBlock->size)
+        {
+            return nullptr;
+        }
+        a_pBlock->used = static_cast<std::size_t>(top + a_size - base);
+        return reinterpret_cast<void*>(top);
+    }
+
+private:
+    // 確保した塊 (最後に確保したものが先頭)
+    Block* m_pHead = nullptr;
+
+    // 追加で確保する塊の大きさ
+    std::size_t m_blockSize;
+
+    // 返却されていない切り出したメモリの数 + 作成した側の1つ
+    std::atomic<std::size_t> m_refCount{ 1 };
+};
+
+
+// BulkArena から切り出すアロケータ
+// std::allocate_shared に渡すと、shared_ptr の制御ブロックと値がアリーナ上に1回で置かれる
+// 切り出すたびにアリーナの参照カウントを増やし、返却されたら減らすので、値が全て破棄されるまでアリーナは解放されない
+// (アロケータ自体のコピーでは参照カウントを操作しない)
+template<typename ValueType>
+class BulkAllocator
+{
+public:
+    using value_type = ValueType;
+
+    explicit BulkAllocator(BulkArena* a_pArena)
+        : m_pArena(a_pArena)
+    {
+    }
+
+    template<typename OtherType>
+    BulkAllocator(const BulkAllocator<OtherType>& a_other)
+        : m_pArena(a_other.GetArena())
+    {
+    }
+
+    ValueType* allocate(std::size_t a_count)
+    {
+        void* p = m_pArena->Allocate(a_count * sizeof(ValueType),alignof(ValueType));
+        m_pArena->AddRef();
+        return static_cast<ValueType*>(p);
+    }
+
+    // 個別には解放しない (最後の返却でアリーナごと解放される)
+    void deallocate(ValueType*,std::size_t)
+    {
+        m_pArena->Release();
+    }
+
+    BulkArena* GetArena() const
+    {
+        return m_pArena;
+    }
+
+    template<typename OtherType>
+    bool operator==(const BulkAllocator<OtherType>& a_other) const
+    {
+        return m_pArena == a_other.GetArena();
+    }
+
+    template<typename OtherType>
+    bool operator!=(const BulkAllocator<OtherType>& a_other) const
+    {
+        return m_pArena != a_other.GetArena();
+    }
+
+private:
+    BulkArena* m_pArena;
+};
+
+#endif // BULK_ALLOCATOR_HPP
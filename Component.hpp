@@ -4,15 +4,39 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector> // typeid のために必要になる場合がある (コンパイラによる)
 #include <typeinfo> // typeid のために必要
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <cassert>
+
+#include "ComponentTypeRegistry.hpp"
+#include "ComponentHook.hpp"
+#include "ArchetypeStorage.hpp"
+#include "ComponentPool.hpp"
+#include "ObjectHandle.hpp"
+#include "RefCountPolicy.hpp"
+#include "ThreadPool.hpp"
+#include "ComponentRecycler.hpp"
+#include "ComponentHandle.hpp"
+#include "ComponentDependency.hpp"
+#include "UpdateContext.hpp"
+#include "NameTable.hpp"
 
 
 
 // 前方宣言
 class ObjectManager; // GameObject が ObjectManager をフレンドクラスとして宣言するため
 class GameObject;
+class ComponentBase;
+
+// プールに格納された1つの型のコンポーネント全てに、処理をまとめて呼ぶ関数 (GameObjectの定義の後で定義する)
+template<typename CompType>
+void DispatchComponentHook(ComponentPoolBase& a_pool,ComponentHookList a_list,const FrameContext& a_frame,ThreadPool* a_pThreadPool);
+void DispatchUntypedComponentHook(ComponentPoolBase& a_pool,ComponentHookList a_list,const FrameContext& a_frame,ThreadPool* a_pThreadPool);
 
 
 class ComponentBase
@@ -33,155 +57,407 @@ public:
     // 通常の更新の後に更新する処理の仮想関数
     virtual void OnPostUpdate() {}
 
+    // 上の処理の、UpdateContext(持ち主・経過時間・フレーム番号・ワールド・一時メモリ)を受け取る版
+    // 更新ではこちらが呼ばれ、オーバーライドしなければ引数無しの版を呼ぶ
+    // 1つの型ではどちらか一方だけをオーバーライドすること (両方オーバーライドすると引数無しの版は呼ばれない)
+    // 型ごとのプールから直接(仮想関数を経由せず)呼べるのは受け取る版だけなので、毎フレーム大量に呼ばれる型は受け取る版をオーバーライドするとよい
+    // (引数無しの版は、受け取る版と引数無しの版の仮想関数を2回経由して呼ばれる)
+    virtual void OnStart(const UpdateContext& a_ctx) { (void)a_ctx; OnStart(); }
+    virtual void OnPreUpdate(const UpdateContext& a_ctx) { (void)a_ctx; OnPreUpdate(); }
+    virtual void OnUpdate(const UpdateContext& a_ctx) { (void)a_ctx; OnUpdate(); }
+    virtual void OnPostUpdate(const UpdateContext& a_ctx) { (void)a_ctx; OnPostUpdate(); }
+
     // コンポーネントが解放されるときの処理の仮想関数
     virtual void OnRelease() {}
 
+    // 破棄されずに再利用されるときの処理の仮想関数
+    // ObjectManager::SetComponentRecycleCapacity で再利用を有効にした型で、OnRelease の後に呼ばれる
+    // 次の AddComponent で生成直後と同じ状態から使えるよう、メンバを初期値に戻す
+    // (引数付きの AddComponent で再利用されたときは、その後で引数から作った値が代入される)
+    virtual void OnReset() {}
+
+    // 同じオブジェクトの他のコンポーネントへの依存を宣言する仮想関数
+    // 持ち主へ追加されたときに一度だけ呼ばれる。Requires/Optional のメンバを a_list.Add で登録すると、
+    // 持ち主がコンポーネントの追加/削除のたびに依存先を解決し直すので、更新処理の中で探す必要が無くなる
+    virtual void DeclareDependencies(ComponentDependencyList& a_list) { (void)a_list; }
+
 
     // このコンポーネントの持ち主を取得
-    std::weak_ptr<GameObject> GetOwner() const // const修飾子を追加
+    WeakPtr<GameObject> GetOwner() const // const修飾子を追加
     {
         return m_wpOwner; // m_spOwner から m_wpOwner に変更
     }
 
+    // このコンポーネントの持ち主を直接取得 (lock() によるアトミック操作が無い)
+    // 持ち主から外されたとき、または持ち主の破棄中にOnReleaseが呼ばれた後はnullptrになる
+    // 更新処理の中など、持ち主が生きていることが分かっている場面で使う
+    GameObject* GetOwnerPtr() const
+    {
+        return m_pOwner;
+    }
+
+    // このコンポーネントの持ち主のハンドルを取得
+    ObjectHandle GetOwnerHandle() const;
+
+    // このコンポーネントが実装している処理のビットの組み合わせ
+    // 型指定のAddComponentで追加されたときに型から求められる (文字列版では全ての処理を呼ぶ)
+    ComponentHookMask GetHookMask() const
+    {
+        return m_hookMask;
+    }
+
+    // 持ち主が有効かつ更新が始まっていて、このコンポーネントの処理を呼んで良いか
+    // 型ごとにまとめて呼ぶときに持ち主を辿らずに済むよう、持ち主の状態が変わるたびに持ち主がセットする
+    bool IsUpdating() const
+    {
+        return m_isUpdating;
+    }
+
 private:
     friend class GameObject; // GameObjectからSetOwnerを呼べるようにする
 
     // このコンポーネントの持ち主をセット
-    void SetOwner(std::shared_ptr<GameObject> a_spOwner)
+    void SetOwner(SharedPtr<GameObject> a_spOwner)
     {
+        m_pOwner = a_spOwner.get();
         m_wpOwner = a_spOwner; // shared_ptr から weak_ptr へ代入
     }
 
+    // 持ち主から外されたときに呼ばれる
+    void ClearOwner()
+    {
+        m_pOwner = nullptr;
+        m_wpOwner.reset();
+        m_isUpdating = false;
+    }
+
 private:
     // このコンポーネントの持ち主 (GameObjectとの循環参照を避けるためweak_ptrにする)
-    std::weak_ptr<GameObject> m_wpOwner;
+    WeakPtr<GameObject> m_wpOwner;
+
+    // 持ち主の生ポインタ (持ち主がコンポーネントを外す/破棄するときにnullptrに戻す)
+    GameObject* m_pOwner = nullptr;
+
+    // 実装している処理のビットの組み合わせ
+    ComponentHookMask m_hookMask = HOOK_ALL;
+
+    // 持ち主が更新中か (IsUpdating を参照)
+    bool m_isUpdating = false;
+
+    // メインスレッドで破棄しなければならないか (IsMainThreadDestroyComponent を参照)
+    // 型指定のAddComponentで追加されたときに型から求められる (文字列版では false)
+    bool m_isMainThreadDestroy = false;
 };
 
 
 
 
-class GameObject: public std::enable_shared_from_this<GameObject> // SetOwnerでthisをshared_ptrとして渡すため
+class GameObject: public EnableSharedFromThis<GameObject> // SetOwnerでthisをshared_ptrとして渡すため
 {
+private:
+    // コンポーネントのIDとインスタンスの組
+    // 1つのオブジェクトが持つコンポーネントは少数なので、ハッシュマップではなく配列に詰めて持つ
+    struct ComponentSlot
+    {
+        ComponentTypeID id;
+        SharedPtr<ComponentBase> spComp;
+    };
+
 public:
+    // コンポーネントの配列などの確保に使うメモリリソースを指定して作成する
+    // ObjectManager から生成されたオブジェクトは ObjectManager に渡したメモリリソースを使う
+    explicit GameObject(std::pmr::memory_resource* a_pMemoryResource)
+        : m_vComps(a_pMemoryResource)
+        , m_vHookList(a_pMemoryResource)
+        , m_vDependencies(a_pMemoryResource)
+    {
+    }
+
+    GameObject()
+        : GameObject(std::pmr::get_default_resource())
+    {
+    }
+
     //---------------------------------
     // Component
     //---------------------------------
 
     // 引数のコンポーネントをアタッチする関数
     // 引数の名前はRTTIが許される環境ならtypeidなどを使うとよい
-   void AddComponent(std::shared_ptr<ComponentBase> a_spComponent,std::string_view a_name)
+    // 名前はここで一度だけIDに変換され、以降はIDで管理される
+   void AddComponent(SharedPtr<ComponentBase> a_spComponent,std::string_view a_name)
     {
-        // コンポーネントの持ち主としてこのオブジェクトをセット
-        // a_spComponent->SetOwner(this); // 直接thisを渡すのは危険。shared_from_this()を使う
-        a_spComponent->SetOwner(shared_from_this());
-
+        ComponentTypeID id = ComponentTypeRegistry::GetID(a_name);
+        AddComponentByID(a_spComponent,id);
 
-        // コンポーネントのインスタンスを名前と紐づけて保存
-        m_umNameToComp[std::string(a_name)] = a_spComponent; // string_viewからstringへ変換
+        // 型は分からないが、IDごとのプールに登録して同じIDのコンポーネントをまとめて更新できるようにする
+        if(m_pComponentPools != nullptr)
+        {
+            m_pComponentPools->GetUntypedPool(id,&DispatchUntypedComponentHook).Insert(m_index,std::move(a_spComponent));
+        }
     }
 
 
     // 引数の名前のコンポーネントを解放し削除する関数
     void RemoveComponent(std::string_view a_compName)
     {
-        auto itr = m_umNameToComp.find(std::string(a_compName)); // string_viewからstringへ変換
-
-        // 引数の名前のコンポーネントが無効なら終了
-        if(itr == m_umNameToComp.end())
+        // 未登録の名前ならそのコンポーネントは存在しない
+        ComponentTypeID id = ComponentTypeRegistry::FindID(a_compName);
+        if(id == INVALID_COMPONENT_TYPE_ID)
         {
             return;
         }
-        if(itr->second == nullptr)
-        {
-            return;
-        }
-
-        // コンポーネントの解放処理を呼ぶ
-        itr->second->OnRelease();
 
-        // コンポーネントのインスタンスを削除
-        m_umNameToComp.erase(std::string(a_compName)); // string_viewからstringへ変換
+        RemoveComponentByID(id);
     }
 
     // コンポーネントを名前から取得
-    std::weak_ptr<ComponentBase> GetComponent(std::string_view a_name)
+    WeakPtr<ComponentBase> GetComponent(std::string_view a_name)
     {
-        auto itr = m_umNameToComp.find(std::string(a_name)); // string_viewからstringへ変換
-        if(itr == m_umNameToComp.end())
+        ComponentTypeID id = ComponentTypeRegistry::FindID(a_name);
+        if(id == INVALID_COMPONENT_TYPE_ID)
         {
-            return std::weak_ptr<ComponentBase>();
+            return WeakPtr<ComponentBase>();
         }
 
-        return itr->second;
+        return GetComponentByID(id);
     }
 
     // コンポーネントを追加する (テンプレート版)
     // 引数からコンストラクタに値を代入することができる
+    // ComponentBase を継承しない型はデータコンポーネントとして ObjectManager のストレージ
+    // (アーキタイプまたは型ごとのプール) に格納され、戻り値は weak_ptr ではなくデータへのポインタになる
     template<typename CompType,typename...ArgTypes>
-    std::weak_ptr<CompType> AddComponent(ArgTypes&&... a_args) // 戻り値を CompType の weak_ptr に変更、引数を完全転送
+    auto AddComponent(ArgTypes&&... a_args) // 戻り値を CompType の weak_ptr に変更、引数を完全転送
+    {
+        if constexpr(std::is_base_of<ComponentBase,CompType>::value)
+        {
+            // 再利用を待っている同じ型のコンポーネントがあれば、作らずにそれを使う
+            if constexpr(sizeof...(ArgTypes) == 0 || std::is_move_assignable<CompType>::value)
+            {
+                if(m_pComponentRecycler != nullptr)
+                {
+                    if(SharedPtr<CompType> spRecycled = m_pComponentRecycler->Take<CompType>())
+                    {
+                        if constexpr(sizeof...(ArgTypes) > 0)
+                        {
+                            *spRecycled = CompType(std::forward<ArgTypes>(a_args)...);
+                        }
+                        return AttachComponent(std::move(spRecycled));
+                    }
+                }
+            }
+
+            // コンポーネントのインスタンスを作成 (メモリリソースを指定されていれば、そこから確保する)
+            std::pmr::memory_resource* pMemoryResource = GetMemoryResource();
+            if(pMemoryResource != std::pmr::new_delete_resource())
+            {
+                return AttachComponent(AllocateShared<CompType>(std::pmr::polymorphic_allocator<CompType>(pMemoryResource),
+                    std::forward<ArgTypes>(a_args)...));
+            }
+            return AttachComponent(MakeShared<CompType>(std::forward<ArgTypes>(a_args)...));
+        }
+        else
+        {
+            if(m_pArchetypeStorage != nullptr)
+            {
+                // 型の組み合わせが変わるので、別のアーキタイプへ移動する
+                return m_pArchetypeStorage->Add<CompType>(m_archetypeLocation,std::forward<ArgTypes>(a_args)...);
+            }
+            if(m_pComponentPools != nullptr)
+            {
+                return &m_pComponentPools->GetPool<CompType>(ComponentTypeRegistry::GetID<CompType>())
+                    .Insert(m_index,std::forward<ArgTypes>(a_args)...);
+            }
+
+            // データコンポーネントは ObjectManager から生成されたオブジェクトでなければ持てない
+            return static_cast<CompType*>(nullptr);
+        }
+    }
+
+    // 作成済みのコンポーネントをアタッチする (型はポインタの型から決まる)
+    // メモリの確保方法を選んで作成したコンポーネント(プレハブなど)を、テンプレート版AddComponentと同じように登録する
+    // ポインタが CompType の派生クラスのインスタンスを指している場合は、派生クラスのオーバーライドを飛ばさないよう、
+    // 文字列版のAddComponentと同じく全ての処理を仮想関数で呼ぶ (GetComponentHandle では指せない)
+    template<typename CompType>
+    WeakPtr<CompType> AttachComponent(SharedPtr<CompType> a_spNewComp)
     {
-        // CompType が ComponentBase から派生しているかチェック (任意)
         static_assert(std::is_base_of<ComponentBase,CompType>::value,"CompType must derive from ComponentBase");
 
-        // コンポーネントのインスタンスを作成
-        std::shared_ptr<CompType> spNewComp = std::make_shared<CompType>(std::forward<ArgTypes>(a_args)...);
+        ComponentBase& comp = static_cast<ComponentBase&>(*a_spNewComp);
+        bool isExactType = typeid(comp) == typeid(CompType);
 
-        // ComponentBaseへのポインタも取得しておく
-        std::shared_ptr<ComponentBase> spNewCompBase = spNewComp;
+        // オーバーライドしていない処理は呼ばなくて済むよう、型から求めておく
+        comp.m_hookMask = isExactType ? GetComponentHookMask<CompType>() : HOOK_ALL;
+        comp.m_isMainThreadDestroy = IsMainThreadDestroyComponent<CompType>();
 
-        // コンポーネントの持ち主としてこのオブジェクトをセット
-        spNewCompBase->SetOwner(shared_from_this());
+        // 型ごとのIDと紐づけて保存 (文字列の生成やハッシュ計算は行わない)
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        AddComponentByID(a_spNewComp,id);
 
-        // コンポーネントのインスタンスを名前と紐づけて保存
-        // typeid(CompType).name() は環境によって異なる mangled name を返す可能性があるため注意
-        m_umNameToComp[typeid(CompType).name()] = spNewCompBase;
+        // 型ごとのプールにも登録し、GetComponent/HasComponent を番号から直接引けるようにする
+        // ObjectManager::UpdateWorld はこのプールを辿り、同じ型のコンポーネントの処理を続けて呼ぶ
+        // 型ごとのプールは CompType::OnUpdate() のように直接呼ぶので、CompType そのもののインスタンスだけを入れる
+        if(m_pComponentPools != nullptr)
+        {
+            if(isExactType)
+            {
+                m_pComponentPools->GetHookedPool<SharedPtr<CompType>>(id,GetComponentHookMask<CompType>(),IsThreadSafeComponent<CompType>(),
+                    &DispatchComponentHook<CompType>)
+                    .Insert(m_index,a_spNewComp);
+            }
+            else
+            {
+                m_pComponentPools->GetUntypedPool(id,&DispatchUntypedComponentHook)
+                    .Insert(m_index,StaticPointerCast<ComponentBase>(a_spNewComp));
+            }
+        }
+
+        return WeakPtr<CompType>(a_spNewComp); // CompType の weak_ptr を返す
+    }
 
-        return spNewComp; // CompType の weak_ptr を返す
+    // 引数の数のコンポーネントを追加しても配列を確保し直さないよう、あらかじめ領域を確保する
+    void ReserveComponents(std::size_t a_count)
+    {
+        m_vComps.reserve(a_count);
+        m_vHookList.reserve(a_count * HOOK_LIST_COUNT);
     }
 
     // 引数の型のコンポーネントを解放し削除する関数 (テンプレート版)
     template<typename CompType>
     void RemoveComponent()
     {
-        // CompType が ComponentBase から派生しているかチェック (任意)
-        static_assert(std::is_base_of<ComponentBase,CompType>::value,"CompType must derive from ComponentBase");
-
-        std::string compName = typeid(CompType).name();
-        auto itr = m_umNameToComp.find(compName);
-
-        // 引数の名前のコンポーネントが無効なら終了
-        if(itr == m_umNameToComp.end())
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        if constexpr(std::is_base_of<ComponentBase,CompType>::value)
         {
-            return;
+            RemoveComponentByID(id);
         }
-        if(itr->second == nullptr)
+        else
         {
-            return;
+            if(m_pArchetypeStorage != nullptr)
+            {
+                m_pArchetypeStorage->Remove(m_archetypeLocation,id);
+            }
+            else if(m_pComponentPools != nullptr)
+            {
+                if(ComponentPoolBase* pPool = m_pComponentPools->FindPoolBase(id))
+                {
+                    pPool->Remove(m_index);
+                }
+            }
         }
+    }
 
-        // コンポーネントの解放処理を呼ぶ
-        itr->second->OnRelease();
+    // コンポーネントを型から取得 (テンプレート版)
+    // データコンポーネントの場合はデータへのポインタを返す (追加/削除で場所が変わるため保持しないこと)
+    template<typename CompType>
+    auto GetComponent() // 戻り値を CompType の weak_ptr に変更
+    {
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        if constexpr(std::is_base_of<ComponentBase,CompType>::value)
+        {
+            // 型ごとのプールに登録されていれば、番号から直接引ける (キャストも不要)
+            if(m_pComponentPools != nullptr)
+            {
+                if(ComponentPool<SharedPtr<CompType>>* pPool = m_pComponentPools->FindPool<SharedPtr<CompType>>(id))
+                {
+                    if(SharedPtr<CompType>* pspComp = pPool->Find(m_index))
+                    {
+                        return WeakPtr<CompType>(*pspComp);
+                    }
+                }
+            }
 
-        // コンポーネントのインスタンスを削除
-        m_umNameToComp.erase(compName);
+            // 文字列版のAddComponentで追加されたコンポーネントはプールに無いため、配列から探す
+            auto itr = FindComponentSlot(id);
+            if(itr == m_vComps.end() || itr->spComp == nullptr)
+            {
+                return WeakPtr<CompType>();
+            }
+
+            // ComponentBase の shared_ptr から CompType の shared_ptr へ動的キャスト
+            // キャストに失敗した場合は nullptr を持つ weak_ptr が返る
+            return WeakPtr<CompType>(DynamicPointerCast<CompType>(itr->spComp));
+        }
+        else
+        {
+            if(m_pArchetypeStorage != nullptr)
+            {
+                return m_pArchetypeStorage->Get<CompType>(m_archetypeLocation);
+            }
+            if(m_pComponentPools != nullptr)
+            {
+                if(ComponentPool<CompType>* pPool = m_pComponentPools->FindPool<CompType>(id))
+                {
+                    return pPool->Find(m_index);
+                }
+            }
+            return static_cast<CompType*>(nullptr);
+        }
     }
 
-    // コンポーネントを型から取得 (テンプレート版)
+    // 引数の型のコンポーネントを指すハンドルを取得する (持っていなければ何も指さないハンドル)
+    // 毎フレーム同じコンポーネントを使う場合は、GetComponent の代わりにこれを一度だけ取得して保持するとよい
+    // ObjectManager から生成されていないオブジェクトや、文字列版の AddComponent で追加されたコンポーネントは指せない
     template<typename CompType>
-    std::weak_ptr<CompType> GetComponent() // 戻り値を CompType の weak_ptr に変更
+    ComponentHandle<CompType> GetComponentHandle()
     {
-        // CompType が ComponentBase から派生しているかチェック (任意)
         static_assert(std::is_base_of<ComponentBase,CompType>::value,"CompType must derive from ComponentBase");
+        if(m_pComponentPools == nullptr)
+        {
+            return ComponentHandle<CompType>();
+        }
+        ComponentPool<SharedPtr<CompType>>* pPool = m_pComponentPools->FindPool<SharedPtr<CompType>>(ComponentTypeRegistry::GetID<CompType>());
+        if(pPool == nullptr || !pPool->Has(m_index))
+        {
+            return ComponentHandle<CompType>();
+        }
+        return ComponentHandle<CompType>(pPool,m_index,pPool->GetGeneration(m_index));
+    }
+
+    // 引数の型のコンポーネントを持っているか (テンプレート版)
+    // ObjectManager から生成されたオブジェクトなら型ごとのプールを引くだけのO(1)
+    template<typename CompType>
+    bool HasComponent()
+    {
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        if constexpr(std::is_base_of<ComponentBase,CompType>::value)
+        {
+            if(m_pComponentPools != nullptr)
+            {
+                ComponentPoolBase* pPool = m_pComponentPools->FindPoolBase(id);
+                if(pPool != nullptr && pPool->Has(m_index))
+                {
+                    return true;
+                }
+            }
+            return !GetComponent<CompType>().expired();
+        }
+        else
+        {
+            if(m_pArchetypeStorage != nullptr)
+            {
+                return m_pArchetypeStorage->Has(m_archetypeLocation,id);
+            }
+            if(m_pComponentPools != nullptr)
+            {
+                ComponentPoolBase* pPool = m_pComponentPools->FindPoolBase(id);
+                return pPool != nullptr && pPool->Has(m_index);
+            }
+            return false;
+        }
+    }
 
-        auto itr = m_umNameToComp.find(typeid(CompType).name());
-        if(itr == m_umNameToComp.end() || itr->second == nullptr)
+    // コンポーネントをIDから取得
+    WeakPtr<ComponentBase> GetComponentByID(ComponentTypeID a_id)
+    {
+        auto itr = FindComponentSlot(a_id);
+        if(itr == m_vComps.end())
         {
-            return std::weak_ptr<CompType>();
+            return WeakPtr<ComponentBase>();
         }
 
-        // ComponentBase の shared_ptr から CompType の shared_ptr へ動的キャスト
-        // キャストに失敗した場合は nullptr を持つ weak_ptr が返る
-        return std::dynamic_pointer_cast<CompType>(itr->second);
+        return itr->spComp;
     }
 
 
@@ -190,9 +466,20 @@ public:
     //---------------------------------
 
     // オブジェクトの有効状態をセットする
+    // ObjectManagerから生成されたオブジェクトを無効にすると、削除待ちとして ObjectManager に積まれ、
+    // 次の ObjectManager::Update で削除される (それまでに有効へ戻せば削除されない)
+    // 削除待ちの配列を操作するため、メインスレッドから呼ぶこと
     void SetActive(bool a_isActive)
     {
         m_isActive = a_isActive;
+        RefreshComponentsUpdating();
+
+        // 既に積まれていれば積まない (無効→有効→無効と切り替えても1回だけ)
+        if(!m_isActive && !m_isPendingRemove && m_pvPendingRemove != nullptr)
+        {
+            m_pvPendingRemove->push_back(GetHandle());
+            m_isPendingRemove = true;
+        }
     }
 
     bool IsActive() const // CheckActive から IsActive に変更し、const修飾子を追加
@@ -200,99 +487,444 @@ public:
         return m_isActive;
     }
 
-    const std::string& GetName() const // 戻り値を const std::string& に変更し、const修飾子を追加
+    // 名前のキーが保持する文字列を指す (名前を登録し直すか、オブジェクトが破棄されるまで有効)
+    std::string_view GetName() const
     {
-        return m_name;
+        return m_nameKey.GetString();
+    }
+
+    // 名前のキー (名前を登録していなければ何も指さないキー)
+    const NameKey& GetNameKey() const
+    {
+        return m_nameKey;
+    }
+
+    // コンポーネントの配列・コンポーネントのインスタンスの確保に使うメモリリソース
+    std::pmr::memory_resource* GetMemoryResource() const
+    {
+        return m_vComps.get_allocator().resource();
+    }
+
+    // OnStartが呼ばれ、更新が始まっているか
+    bool IsStarted() const
+    {
+        return m_isCalledUpdate;
+    }
+
+    // 必ず必要な依存(Requires)が見つからないときに呼ぶ関数を設定する (デバッグ用、全てのオブジェクトで共通)
+    // 設定しなければデバッグビルドでは assert で止まり、リリースビルドでは何もしない
+    // 確かめるのは OnStart の直前と、開始後にコンポーネントを追加/削除した次の UpdateWorld
+    static void SetMissingDependencyHandler(MissingDependencyHandler a_pfnHandler)
+    {
+        GetMissingDependencyHandler() = a_pfnHandler;
+    }
+
+    // このオブジェクトを参照するハンドルを取得する
+    // ObjectManagerから生成されていない、または既に取り除かれたオブジェクトなら何も指さないハンドルになる
+    ObjectHandle GetHandle() const
+    {
+        return ObjectHandle{ m_index,m_generation };
     }
 
 private:
     friend class ObjectManager; // ObjectManagerから private メンバにアクセス許可
 
-    // 名前をセットする (ObjectManagerからのみ呼ばれることを想定)
-    void SetName(std::string_view a_name)
+    // コンポーネントをIDと紐づけてアタッチする
+    void AddComponentByID(SharedPtr<ComponentBase> a_spComponent,ComponentTypeID a_id)
     {
-        m_name = a_name;
+        // 他のシステムと同時に実行している間は追加できない (SystemStructuralChange を宣言すること)
+        assert(!StructuralChangeLock::IsLocked() && "AddComponent in a system without SystemStructuralChange");
+
+        // コンポーネントの持ち主としてこのオブジェクトをセット
+        // a_spComponent->SetOwner(this); // 直接thisを渡すのは危険。shared_from_this()を使う
+        a_spComponent->SetOwner(shared_from_this());
+        a_spComponent->m_isUpdating = m_isActive && m_isCalledUpdate;
+
+        // 同じIDでプールに登録されているコンポーネントがあれば、置き換わるので外しておく
+        // (登録は呼び出し元の AddComponent が行う)
+        RemovePooledComponent(a_id);
+
+        // 追加するコンポーネントの依存を登録する (同じインスタンスを追加し直したときは登録済みなので重ねない)
+        ComponentBase* pNewComp = a_spComponent.get();
+        bool isDeclared = std::any_of(m_vDependencies.begin(),m_vDependencies.end(),
+            [pNewComp](const ComponentDependencySlot& a_slot) { return a_slot.pDeclarer == pNewComp; });
+        if(!isDeclared)
+        {
+            ComponentDependencyList dependencyList(m_vDependencies,pNewComp);
+            pNewComp->DeclareDependencies(dependencyList);
+        }
+
+        // コンポーネントのインスタンスをIDと紐づけて保存
+        // IDの昇順を保つ位置に挿入する (同じIDが既にあれば上書き)
+        auto itr = std::lower_bound(m_vComps.begin(),m_vComps.end(),a_id,
+            [](const ComponentSlot& a_slot,ComponentTypeID a_key) { return a_slot.id < a_key; });
+        if(itr != m_vComps.end() && itr->id == a_id)
+        {
+            if(itr->spComp && itr->spComp != a_spComponent)
+            {
+                RemoveDependencies(itr->spComp.get());
+                itr->spComp->ClearOwner();
+            }
+            itr->spComp = std::move(a_spComponent);
+        }
+        else
+        {
+            m_vComps.insert(itr,ComponentSlot{ a_id,std::move(a_spComponent) });
+        }
+        RebuildHookLists();
+        ResolveDependencies();
+        RequestDependencyCheck();
     }
 
+    // 引数のIDのコンポーネントを解放し削除する
+    void RemoveComponentByID(ComponentTypeID a_id)
+    {
+        // 他のシステムと同時に実行している間は削除できない (SystemStructuralChange を宣言すること)
+        assert(!StructuralChangeLock::IsLocked() && "RemoveComponent in a system without SystemStructuralChange");
 
-    //---------------------------------
-    // 更新 (ObjectManagerから呼ばれることを想定)
-    //---------------------------------
-public: // ObjectManagerから呼び出せるようにpublicに変更 (またはObjectManagerをfriendにする)
-    // もしGameObject自身が更新ループを持つならprivateのままでも良い
+        auto itr = FindComponentSlot(a_id);
 
-// 通常の更新の前に呼ぶ処理
-    void PreUpdate()
+        // 引数のIDのコンポーネントが無効なら終了
+        if(itr == m_vComps.end())
+        {
+            return;
+        }
+        if(itr->spComp == nullptr)
+        {
+            return;
+        }
+
+        // コンポーネントの解放処理を呼ぶ
+        itr->spComp->OnRelease();
+
+        // OnRelease中にコンポーネントが追加/削除されているとイテレータが無効になるため探し直す
+        itr = FindComponentSlot(a_id);
+        if(itr == m_vComps.end())
+        {
+            return;
+        }
+
+        // コンポーネントのインスタンスを配列とプールから外す
+        SharedPtr<ComponentBase> spRemoved;
+        if(itr->spComp)
+        {
+            RemoveDependencies(itr->spComp.get());
+            itr->spComp->ClearOwner();
+            spRemoved = std::move(itr->spComp);
+        }
+        m_vComps.erase(itr);
+        RebuildHookLists();
+        ResolveDependencies();
+        RequestDependencyCheck();
+
+        RemovePooledComponent(a_id);
+
+        // 再利用が有効な型なら破棄せずに溜める (溜められなければここで破棄される)
+        if(spRemoved != nullptr && m_pComponentRecycler != nullptr)
+        {
+            m_pComponentRecycler->Recycle(a_id,spRemoved);
+        }
+    }
+
+    // 引数のIDのコンポーネントを型ごとのプール・IDごとのプールから外す
+    void RemovePooledComponent(ComponentTypeID a_id)
     {
-        if(!m_isActive) return; // 非アクティブなら何もしない
+        if(m_pComponentPools == nullptr)
+        {
+            return;
+        }
+        if(ComponentPoolBase* pPool = m_pComponentPools->FindPoolBase(a_id))
+        {
+            pPool->Remove(m_index);
+        }
+        if(ComponentPoolBase* pPool = m_pComponentPools->FindUntypedPoolBase(a_id))
+        {
+            pPool->Remove(m_index);
+        }
+    }
 
-        // 初めての更新ならStartを呼ぶ
-        if(!m_isCalledUpdate)
+    // 処理ごとに、その処理を実装しているコンポーネントだけを並べた配列を作り直す
+    // コンポーネントの追加/削除のたびに呼ばれる (コンポーネントは少数なので全て作り直す)
+    void RebuildHookLists()
+    {
+        m_vHookList.clear();
+        for(std::size_t list = 0; list < HOOK_LIST_COUNT; ++list)
         {
-            // OnStart中にコンポーネントが追加/削除される可能性を考慮し、イテレータが無効にならないように注意
-            // 一度キーを収集してから処理するなどの対策が考えられるが、ここではシンプルに直接ループ
-            for(auto& pair : m_umNameToComp) // 範囲for文の参照を修正
+            m_hookListBegin[list] = static_cast<std::uint16_t>(m_vHookList.size());
+            for(const ComponentSlot& slot : m_vComps)
             {
-                if(pair.second) pair.second->OnStart();
+                if(slot.spComp && (slot.spComp->m_hookMask & HOOK_LIST_MASKS[list]) != 0)
+                {
+                    m_vHookList.push_back(slot.spComp.get());
+                }
             }
-            m_isCalledUpdate = true;
         }
+        m_hookListBegin[HOOK_LIST_COUNT] = static_cast<std::uint16_t>(m_vHookList.size());
+    }
 
-        // 全てのコンポーネントのPreUpdateを呼ぶ
-        for(auto& pair : m_umNameToComp) // 範囲for文の参照を修正
+    // 宣言された依存を全て解決し直す
+    // コンポーネントの追加/削除のたびに呼ばれる (依存先のポインタが古いままにならないようにする)
+    void ResolveDependencies()
+    {
+        for(const ComponentDependencySlot& slot : m_vDependencies)
         {
-            if(pair.second) // nullptrチェック
+            ComponentDependencyBase& dependency = *slot.pDependency;
+            auto itr = FindComponentSlot(dependency.m_id);
+            ComponentBase* pTarget = itr != m_vComps.end() ? itr->spComp.get() : nullptr;
+            dependency.m_pTarget = pTarget != nullptr ? dependency.m_pfnCast(pTarget) : nullptr;
+        }
+    }
+
+    // 引数のコンポーネントが宣言した依存を外す (依存先のポインタも消しておく)
+    void RemoveDependencies(ComponentBase* a_pDeclarer)
+    {
+        auto itrEnd = std::remove_if(m_vDependencies.begin(),m_vDependencies.end(),
+            [a_pDeclarer](const ComponentDependencySlot& a_slot)
             {
-                pair.second->OnPreUpdate();
+                if(a_slot.pDeclarer != a_pDeclarer) return false;
+                a_slot.pDependency->m_pTarget = nullptr;
+                return true;
+            });
+        m_vDependencies.erase(itrEnd,m_vDependencies.end());
+    }
+
+    // 必ず必要な依存が揃っているかを後で確かめるよう印を付ける
+    // 追加の順番 (Renderer を追加してから Transform を追加するなど) で途中に足りないのは正しい使い方なので、
+    // 開始前ならOnStartの直前に、開始後なら次の UpdateWorld でまとめて確かめる
+    void RequestDependencyCheck()
+    {
+        if(m_isDependencyCheckPending || m_vDependencies.empty())
+        {
+            return;
+        }
+        m_isDependencyCheckPending = true;
+
+        // 開始前のオブジェクトは既に ObjectManager の開始待ちの配列に積まれている
+        if(m_isCalledUpdate && m_pvPendingStart != nullptr)
+        {
+            m_pvPendingStart->push_back(GetHandle());
+        }
+    }
+
+    // 見つからない、必ず必要な依存を報告する
+    void CheckMissingDependencies()
+    {
+        m_isDependencyCheckPending = false;
+        for(const ComponentDependencySlot& slot : m_vDependencies)
+        {
+            const ComponentDependencyBase& dependency = *slot.pDependency;
+            if(!dependency.IsRequired() || dependency.IsResolved()) continue;
+
+            MissingDependencyHandler pfnHandler = GetMissingDependencyHandler();
+            if(pfnHandler != nullptr)
+            {
+                pfnHandler(*this,*slot.pDeclarer,dependency.GetTypeID());
+            }
+            else
+            {
+                assert(false && "required component dependency is missing (see GameObject::SetMissingDependencyHandler)");
             }
         }
     }
 
-    // 通常の更新処理
-    void Update()
+    static MissingDependencyHandler& GetMissingDependencyHandler()
     {
-        if(!m_isActive) return; // 非アクティブなら何もしない
+        static MissingDependencyHandler s_pfnHandler = nullptr;
+        return s_pfnHandler;
+    }
 
-        // 全てのコンポーネントのUpdateを呼ぶ
-        for(auto& pair : m_umNameToComp) // 範囲for文の参照を修正
+    // 引数の処理を実装しているコンポーネント全てに関数を呼ぶ
+    // 処理の中でコンポーネントが追加/削除されると配列が作り直されるため、毎回範囲を読み直す
+    template<typename Func>
+    void CallHook(std::size_t a_list,Func a_func)
+    {
+        for(std::size_t i = m_hookListBegin[a_list]; i < m_hookListBegin[a_list + 1]; ++i)
         {
-            if(pair.second) // nullptrチェック
+            a_func(m_vHookList[i]);
+        }
+    }
+
+    // 引数のIDのコンポーネントが格納されている位置を探す
+    // コンポーネントの数は少ないため、IDの昇順に並んだ配列を二分探索する
+    std::pmr::vector<ComponentSlot>::iterator FindComponentSlot(ComponentTypeID a_id)
+    {
+        auto itr = std::lower_bound(m_vComps.begin(),m_vComps.end(),a_id,
+            [](const ComponentSlot& a_slot,ComponentTypeID a_key) { return a_slot.id < a_key; });
+        if(itr == m_vComps.end() || itr->id != a_id)
+        {
+            return m_vComps.end();
+        }
+        return itr;
+    }
+
+    // ObjectManagerのストレージからこのオブジェクトの値を全て取り除き、関連を切る
+    // データコンポーネントは破棄され、通常のコンポーネントはこのオブジェクトの配列にだけ残る
+    void DetachStorage()
+    {
+        if(m_pArchetypeStorage != nullptr)
+        {
+            m_pArchetypeStorage->RemoveAll(m_archetypeLocation);
+            m_pArchetypeStorage = nullptr;
+        }
+        if(m_pComponentPools != nullptr)
+        {
+            m_pComponentPools->RemoveAll(m_index);
+            m_pComponentPools = nullptr;
+        }
+        m_pvPendingRemove = nullptr;
+        m_pvPendingStart = nullptr;
+        m_pComponentRecycler = nullptr;
+        m_index = INVALID_OBJECT_INDEX;
+        m_generation = 0;
+    }
+
+    // 初めての更新ならOnStartを呼ぶ
+    // コンポーネントを追加/削除していれば、その前に必ず必要な依存が揃っているかを確かめる
+    void Start(const FrameContext& a_frame)
+    {
+        if(m_isDependencyCheckPending) CheckMissingDependencies();
+        if(!m_isActive || m_isCalledUpdate) return;
+
+        // OnStart中にコンポーネントが追加/削除される可能性を考慮し、イテレータではなく添え字でループする
+        UpdateContext ctx(*this,a_frame);
+        CallHook(HOOK_LIST_START,[&ctx](ComponentBase* a_pComp) { a_pComp->OnStart(ctx); });
+        m_isCalledUpdate = true;
+        RefreshComponentsUpdating();
+    }
+
+    // 全てのコンポーネントの OnRelease を呼び、持ち主から外す (デストラクタでは呼ばなくなる)
+    // 破棄を別のスレッドで行う前に、メインスレッドで呼ぶ
+    // メインスレッドで破棄しなければならないコンポーネントは、このオブジェクトから引数の配列へ移す
+    void ReleaseComponents(std::vector<SharedPtr<ComponentBase>>& a_vMainThreadComps)
+    {
+        if(m_isReleased) return;
+        m_isReleased = true;
+
+        // OnRelease中にコンポーネントが追加/削除される可能性を考慮し、添え字でループする
+        for(std::size_t i = 0; i < m_vComps.size(); ++i)
+        {
+            if(m_vComps[i].spComp)
             {
-                pair.second->OnUpdate();
+                m_vComps[i].spComp->OnRelease();
+                m_vComps[i].spComp->ClearOwner();
+            }
+        }
+        for(ComponentSlot& slot : m_vComps)
+        {
+            if(slot.spComp && slot.spComp->m_isMainThreadDestroy)
+            {
+                a_vMainThreadComps.push_back(std::move(slot.spComp));
             }
         }
     }
 
-    // 通常の更新の後に呼ぶ
-// 通常の更新の後に呼ぶ処理
-    void PostUpdate()
+    // ReleaseComponents の後に呼び、再利用できるコンポーネントを引数へ移す
+    void RecycleComponents(ComponentRecycler& a_recycler)
     {
-        if(!m_isActive) return; // 非アクティブなら何もしない
-
-        // 全てのコンポーネントのPostUpdateを呼ぶ
-        for(auto& pair : m_umNameToComp) // 範囲for文の参照を修正
+        for(ComponentSlot& slot : m_vComps)
         {
-            if(pair.second) // nullptrチェック
+            if(slot.spComp)
             {
-                pair.second->OnPostUpdate();
+                a_recycler.Recycle(slot.id,slot.spComp);
             }
         }
     }
 
+    // ReleaseComponents の後に呼び、生成直後と同じ状態に戻す (ObjectManagerが再利用するときに呼ぶ)
+    // 残っているコンポーネントはここで破棄される。配列の領域は確保したまま使い回す
+    void ResetForReuse()
+    {
+        m_vComps.clear();
+        m_vHookList.clear();
+        m_vDependencies.clear();
+        std::fill(std::begin(m_hookListBegin),std::end(m_hookListBegin),static_cast<std::uint16_t>(0));
+        m_nameKey = NameKey();
+        m_isCalledUpdate = false;
+        m_isActive = false;
+        m_isNameRegistered = false;
+        m_isPendingRemove = false;
+        m_isDependencyCheckPending = false;
+        m_isReleased = false;
+        m_archetypeLocation = ArchetypeLocation{ nullptr,0,this };
+    }
+
+    // 有効状態や更新の開始をコンポーネントへ伝える
+    void RefreshComponentsUpdating()
+    {
+        bool isUpdating = m_isActive && m_isCalledUpdate;
+        for(const ComponentSlot& slot : m_vComps)
+        {
+            if(slot.spComp) slot.spComp->m_isUpdating = isUpdating;
+        }
+    }
+
+    // 名前をセットする (ObjectManagerからのみ呼ばれることを想定)
+    void SetNameKey(NameKey a_nameKey)
+    {
+        m_nameKey = std::move(a_nameKey);
+    }
+
+
+    //---------------------------------
+    // 更新 (ObjectManagerから呼ばれることを想定)
+    //---------------------------------
+public: // ObjectManagerから呼び出せるようにpublicに変更 (またはObjectManagerをfriendにする)
+    // もしGameObject自身が更新ループを持つならprivateのままでも良い
+
+    // 以下の引数無しの版は、ワールド・一時メモリ無しの既定の FrameContext (経過時間は1/60秒) で呼ぶ
+
+// 通常の更新の前に呼ぶ処理
+    void PreUpdate(const FrameContext& a_frame = FrameContext())
+    {
+        if(!m_isActive) return; // 非アクティブなら何もしない
+
+        // 初めての更新ならStartを呼ぶ
+        Start(a_frame);
+
+        // OnPreUpdateを実装しているコンポーネントだけPreUpdateを呼ぶ
+        UpdateContext ctx(*this,a_frame);
+        CallHook(HOOK_LIST_PRE_UPDATE,[&ctx](ComponentBase* a_pComp) { a_pComp->OnPreUpdate(ctx); });
+    }
+
+    // 通常の更新処理
+    void Update(const FrameContext& a_frame = FrameContext())
+    {
+        if(!m_isActive) return; // 非アクティブなら何もしない
+
+        // OnUpdateを実装しているコンポーネントだけUpdateを呼ぶ
+        UpdateContext ctx(*this,a_frame);
+        CallHook(HOOK_LIST_UPDATE,[&ctx](ComponentBase* a_pComp) { a_pComp->OnUpdate(ctx); });
+    }
+
+    // 通常の更新の後に呼ぶ
+// 通常の更新の後に呼ぶ処理
+    void PostUpdate(const FrameContext& a_frame = FrameContext())
+    {
+        if(!m_isActive) return; // 非アクティブなら何もしない
+
+        // OnPostUpdateを実装しているコンポーネントだけPostUpdateを呼ぶ
+        UpdateContext ctx(*this,a_frame);
+        CallHook(HOOK_LIST_POST_UPDATE,[&ctx](ComponentBase* a_pComp) { a_pComp->OnPostUpdate(ctx); });
+    }
+
     // GameObjectが破棄される際に、保持している全コンポーネントのOnReleaseを呼ぶ
     // ObjectManagerなどでGameObjectがリストから削除される直前などに明示的に呼ぶか、
     // GameObjectのデストラクタで呼ぶことを検討。
     // ここではデストラクタで呼ぶ例を示す。
  
    ~GameObject() {
-         std::cout << "[GameObject] Destructor for: " << m_name << std::endl;
-        for(auto& pair : m_umNameToComp) {
-            if(pair.second) {
-                // std::cout << "[GameObject] Calling OnRelease for component in " << m_name << std::endl;
-                pair.second->OnRelease();
+         std::cout << "[GameObject] Destructor for: " << GetName() << std::endl;
+        for(std::size_t i = 0; i < m_vComps.size(); ++i) {
+            if(m_vComps[i].spComp && !m_isReleased) {
+                // std::cout << "[GameObject] Calling OnRelease for component in " << GetName() << std::endl;
+                m_vComps[i].spComp->OnRelease();
+                m_vComps[i].spComp->ClearOwner();
             }
         }
-        m_umNameToComp.clear(); // shared_ptrが解放される
+        m_vComps.clear(); // shared_ptrが解放される
+
+        // ストレージに残っている値も破棄する (通常はObjectManagerから削除されるときに破棄済み)
+        DetachStorage();
     }
 
 
@@ -304,20 +936,182 @@ private:
     // オブジェクトが有効か
     bool m_isActive = false; // デフォルトはfalseが良いかもしれない（生成後SetActive(true)で有効化）
 
-    // オブジェクトの名前
-    std::string m_name;
+    // オブジェクトの名前 (文字列はキーが参照カウントで保持するので、ObjectManager より長生きしても無効にならない)
+    NameKey m_nameKey;
+
+    // ObjectManagerに名前が登録されているか (名前無しで生成されたオブジェクトはfalse)
+    bool m_isNameRegistered = false;
+
+    // コンポーネントのID(型または指定した名前から ComponentTypeRegistry が割り振る)とインスタンスの組を
+    // IDの昇順に並べて格納するコンテナ (更新時は連続したメモリを順に辿るだけになる)
+    std::pmr::vector<ComponentSlot> m_vComps;
 
-    // コンポーネントの名前(typeid().name() または指定した名前)とインスタンスを紐づけて格納するコンテナ
-    // キーを std::string に統一
-    std::unordered_map<std::string,std::shared_ptr<ComponentBase>> m_umNameToComp;
+    // 処理ごとに、その処理を実装しているコンポーネントだけを並べた配列
+    // 処理ごとの配列を1つの配列に続けて並べ、m_hookListBegin で各処理の開始位置を持つ
+    std::pmr::vector<ComponentBase*> m_vHookList;
+    std::uint16_t m_hookListBegin[HOOK_LIST_COUNT + 1] = {};
+
+    // コンポーネントが宣言した依存 (コンポーネントの追加/削除のたびに解決し直す)
+    std::pmr::vector<ComponentDependencySlot> m_vDependencies;
+
+    // データコンポーネントをアーキタイプに格納するストレージ (ObjectManagerが所有し、生成時にセットする)
+    ArchetypeStorage* m_pArchetypeStorage = nullptr;
+
+    // 型ごとのプール (ObjectManagerが所有し、生成時にセットする)
+    ComponentPools* m_pComponentPools = nullptr;
+
+    // 破棄されたコンポーネントを再利用するための入れ物 (ObjectManagerが所有し、生成時にセットする)
+    ComponentRecycler* m_pComponentRecycler = nullptr;
+
+    // 無効にされたオブジェクトを積む削除待ちの配列 (ObjectManagerが所有し、生成時にセットする)
+    std::vector<ObjectHandle>* m_pvPendingRemove = nullptr;
+
+    // 開始待ちの配列 (ObjectManagerが所有し、生成時にセットする。開始後に依存を確かめ直すときにも積む)
+    std::vector<ObjectHandle>* m_pvPendingStart = nullptr;
+
+    // 削除待ちの配列に積まれているか
+    bool m_isPendingRemove = false;
+
+    // 次の Start で必ず必要な依存が揃っているかを確かめるか
+    bool m_isDependencyCheckPending = false;
+
+    // ReleaseComponents で OnRelease を呼び終えているか
+    bool m_isReleased = false;
+
+    // ObjectManagerが割り振ったこのオブジェクトの番号 (プールの添え字になる)
+    ObjectIndex m_index = INVALID_OBJECT_INDEX;
+
+    // 番号が割り振られたときの世代 (ハンドルの有効判定に使う)
+    std::uint32_t m_generation = 0;
+
+    // データコンポーネントが格納されているアーキタイプと行
+    ArchetypeLocation m_archetypeLocation{ nullptr,0,this };
 
 };
+
+
+// GameObjectの定義が必要なため、クラスの外で定義する
+inline ObjectHandle ComponentBase::GetOwnerHandle() const
+{
+    return m_pOwner != nullptr ? m_pOwner->GetHandle() : ObjectHandle();
+}
+
+
+namespace ComponentHookDetail
+{
+    // 複数のスレッドで呼ぶとき、1つのスレッドへまとめて渡すコンポーネントの数
+    constexpr std::size_t PARALLEL_GRAIN_SIZE = 1024;
+
+    // プールの先頭から順に、持ち主が更新中のコンポーネントへ関数を呼ぶ
+    // 関数には、持ち主と a_frame から作った UpdateContext も渡す (持ち主は更新中なら必ずいるので lock() しない)
+    // 処理の中で追加されたコンポーネントは次のフレームから呼ぶよう、辿る数は最初に決めておく
+    // 削除されたものはUnlockまでプールに残る (処理中のコンポーネントが破棄されることは無い)
+    // スレッドプールが渡されたら範囲に分けて複数のスレッドで呼び、全て終わるまで待つ
+    template<typename ValueType,typename Func>
+    void DispatchPool(ComponentPool<ValueType>& a_pool,const FrameContext& a_frame,ThreadPool* a_pThreadPool,Func a_func)
+    {
+        a_pool.Lock();
+        std::vector<ValueType>& vDense = a_pool.GetDense();
+        auto dispatchRange = [&](std::size_t a_begin,std::size_t a_end)
+            {
+                for(std::size_t i = a_begin; i < a_end; ++i)
+                {
+                    if(!a_pool.IsAlive(i))
+                    {
+                        continue;
+                    }
+                    auto* pComp = vDense[i].get();
+                    if(pComp->IsUpdating())
+                    {
+                        a_func(*pComp,UpdateContext(*pComp->GetOwnerPtr(),a_frame));
+                    }
+                }
+            };
+
+        std::size_t count = vDense.size();
+        if(a_pThreadPool != nullptr)
+        {
+            a_pThreadPool->ParallelFor(count,PARALLEL_GRAIN_SIZE,dispatchRange);
+        }
+        else
+        {
+            dispatchRange(0,count);
+        }
+        a_pool.Unlock();
+    }
+
+    // 型が分かっているコンポーネントの処理を、仮想関数を経由せずに呼ぶ
+    // オブジェクトごとの更新(GameObject::Update)は UpdateContext を受け取る版を仮想関数で呼ぶので、ここでも必ず同じ関数を呼ぶ
+    // CompType から UpdateContext を受け取る版のオーバーライドが見えていれば、それが最終的な呼び先なので直接呼ぶ
+    // 引数無しの版だけを宣言した型では受け取る版が隠れ、基底クラスがオーバーライドしているか分からないため仮想関数で呼ぶ
+    // (基底クラスを辿る方法が無いので、コンパイル時には判定できない。費用は HookDispatchBench で計測している)
+#define COMPONENT_HOOK_CALLER(HookName)                                                         \
+    template<typename CompType>                                                                 \
+    void Call##HookName(CompType& a_comp,const UpdateContext& a_ctx)                            \
+    {                                                                                           \
+        if constexpr(CanCallDirect##HookName##WithContext<CompType>::value &&                   \
+                     Overrides##HookName##WithContext<CompType>::value) a_comp.CompType::HookName(a_ctx); \
+        else static_cast<ComponentBase&>(a_comp).HookName(a_ctx);                               \
+    }
+
+    COMPONENT_HOOK_CALLER(OnPreUpdate)
+    COMPONENT_HOOK_CALLER(OnUpdate)
+    COMPONENT_HOOK_CALLER(OnPostUpdate)
+#undef COMPONENT_HOOK_CALLER
+}
+
+// 同じ型のコンポーネントを続けて呼ぶため、呼び先が毎回同じになる
+// プールにはその型そのもののインスタンスしか入らないので、CompType::OnUpdate() のように仮想関数を経由せず呼ぶ
+// a_pThreadPool は THREAD_SAFE を宣言した型のときだけ ObjectManager から渡される
+template<typename CompType>
+void DispatchComponentHook(ComponentPoolBase& a_pool,ComponentHookList a_list,const FrameContext& a_frame,ThreadPool* a_pThreadPool)
+{
+    using namespace ComponentHookDetail;
+    ComponentPool<SharedPtr<CompType>>& pool = static_cast<ComponentPool<SharedPtr<CompType>>&>(a_pool);
+    switch(a_list)
+    {
+    case HOOK_LIST_PRE_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](CompType& a_comp,const UpdateContext& a_ctx) { CallOnPreUpdate(a_comp,a_ctx); });
+        break;
+    case HOOK_LIST_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](CompType& a_comp,const UpdateContext& a_ctx) { CallOnUpdate(a_comp,a_ctx); });
+        break;
+    case HOOK_LIST_POST_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](CompType& a_comp,const UpdateContext& a_ctx) { CallOnPostUpdate(a_comp,a_ctx); });
+        break;
+    default:
+        // OnStartはオブジェクトごとに呼ぶ (GameObject::PreUpdate を参照)
+        break;
+    }
+}
+
+// 文字列版のAddComponentで追加されたコンポーネントは型が分からないため、仮想関数で呼ぶ
+inline void DispatchUntypedComponentHook(ComponentPoolBase& a_pool,ComponentHookList a_list,const FrameContext& a_frame,ThreadPool* a_pThreadPool)
+{
+    using namespace ComponentHookDetail;
+    ComponentPool<SharedPtr<ComponentBase>>& pool = static_cast<ComponentPool<SharedPtr<ComponentBase>>&>(a_pool);
+    switch(a_list)
+    {
+    case HOOK_LIST_PRE_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](ComponentBase& a_comp,const UpdateContext& a_ctx) { a_comp.OnPreUpdate(a_ctx); });
+        break;
+    case HOOK_LIST_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](ComponentBase& a_comp,const UpdateContext& a_ctx) { a_comp.OnUpdate(a_ctx); });
+        break;
+    case HOOK_LIST_POST_UPDATE:
+        DispatchPool(pool,a_frame,a_pThreadPool,[](ComponentBase& a_comp,const UpdateContext& a_ctx) { a_comp.OnPostUpdate(a_ctx); });
+        break;
+    default:
+        break;
+    }
+}
+
 /*
 template<typename CompType,typename...ArgTypes>
-std::weak_ptr<ComponentBase> AddComponent(ArgTypes... a_args)
+WeakPtr<ComponentBase> AddComponent(ArgTypes... a_args)
 {
     // コンポーネントのインスタンスを作成
-    std::shared_ptr<ComponentBase> spNewComp = std::make_shared<CompType>(a_args...);
+    SharedPtr<ComponentBase> spNewComp = MakeShared<CompType>(a_args...);
 
     // コンポーネントの持ち主としてこのオブジェクトをセット
     spNewComp->SetOwner(this);
@@ -0,0 +1,155 @@
+﻿#ifndef COMPONENT_DEPENDENCY_HPP
+#define COMPONENT_DEPENDENCY_HPP
+
+#include <vector>
+#include <memory_resource>
+
+#include "ComponentTypeRegistry.hpp"
+
+
+
+// 前方宣言
+class ComponentBase;
+class GameObject;
+
+
+// 同じオブジェクトの他のコンポーネントへの依存 (Requires/Optional の基底クラス)
+// 持ち主がコンポーネントの追加/削除のたびに解決し直し、依存先を直接指すポインタを持つ
+class ComponentDependencyBase
+{
+public:
+    // 依存先が見つかっているか
+    bool IsResolved() const
+    {
+        return m_pTarget != nullptr;
+    }
+
+    // 依存先の型のID
+    ComponentTypeID GetTypeID() const
+    {
+        return m_id;
+    }
+
+    // 無いことを報告すべき依存か
+    bool IsRequired() const
+    {
+        return m_isRequired;
+    }
+
+protected:
+    // 見つかったコンポーネントが依存先の型なら、そのまま返す (違う型ならnullptr)
+    using CastFunc = ComponentBase* (*)(ComponentBase*);
+
+    ComponentDependencyBase(ComponentTypeID a_id,bool a_isRequired,CastFunc a_pfnCast)
+        : m_id(a_id)
+        , m_isRequired(a_isRequired)
+        , m_pfnCast(a_pfnCast)
+    {
+    }
+
+    ComponentBase* m_pTarget = nullptr;
+
+private:
+    friend class GameObject; // GameObjectから解決できるようにする
+
+    ComponentTypeID m_id;
+    bool m_isRequired;
+    CastFunc m_pfnCast;
+};
+
+
+// 同じオブジェクトの引数の型のコンポーネントへの依存 (Requires/Optional の共通部分)
+template<typename CompType>
+class ComponentDependency : public ComponentDependencyBase
+{
+public:
+    // 依存先のコンポーネント (無ければnullptr)
+    // 持ち主がコンポーネントの追加/削除のたびに解決し直すので、毎フレーム探す必要は無い
+    CompType* Get() const
+    {
+        return static_cast<CompType*>(m_pTarget);
+    }
+
+    CompType* operator->() const
+    {
+        return Get();
+    }
+
+    explicit operator bool() const
+    {
+        return m_pTarget != nullptr;
+    }
+
+protected:
+    explicit ComponentDependency(bool a_isRequired)
+        : ComponentDependencyBase(ComponentTypeRegistry::GetID<CompType>(),a_isRequired,&CastTarget)
+    {
+    }
+
+private:
+    // 文字列版のAddComponentで同じIDに別の型が登録されていることがあるので、解決するときだけ型を確かめる
+    static ComponentBase* CastTarget(ComponentBase* a_pComp)
+    {
+        return dynamic_cast<CompType*>(a_pComp) != nullptr ? a_pComp : nullptr;
+    }
+};
+
+
+// 必ず必要な依存 (持ち主に無ければ、OnStart の直前か、開始後に追加/削除した次の UpdateWorld で報告される)
+// 例: Requires<TransformComponent> transform; を持ち、DeclareDependencies で a_list.Add(transform) する
+template<typename CompType>
+class Requires : public ComponentDependency<CompType>
+{
+public:
+    Requires()
+        : ComponentDependency<CompType>(true)
+    {
+    }
+};
+
+// 無くても良い依存 (無ければ Get() が nullptr を返すだけ)
+template<typename CompType>
+class Optional : public ComponentDependency<CompType>
+{
+public:
+    Optional()
+        : ComponentDependency<CompType>(false)
+    {
+    }
+};
+
+
+// 必ず必要な依存が見つからないことを報告する関数 (持ち主・依存を宣言したコンポーネント・見つからない型のID)
+// GameObject::SetMissingDependencyHandler で設定する (設定しなければデバッグビルドでは assert で止まる)
+using MissingDependencyHandler = void (*)(const GameObject& a_owner,const ComponentBase& a_declarer,ComponentTypeID a_id);
+
+
+// コンポーネントが宣言した依存と、宣言したコンポーネントの組
+struct ComponentDependencySlot
+{
+    ComponentBase* pDeclarer;
+    ComponentDependencyBase* pDependency;
+};
+
+// ComponentBase::DeclareDependencies に渡され、依存を持ち主へ登録する
+class ComponentDependencyList
+{
+public:
+    ComponentDependencyList(std::pmr::vector<ComponentDependencySlot>& a_vSlots,ComponentBase* a_pDeclarer)
+        : m_vSlots(a_vSlots)
+        , m_pDeclarer(a_pDeclarer)
+    {
+    }
+
+    // 依存を登録する (引数はコンポーネントのメンバであること)
+    void Add(ComponentDependencyBase& a_dependency)
+    {
+        m_vSlots.push_back(ComponentDependencySlot{ m_pDeclarer,&a_dependency });
+    }
+
+private:
+    std::pmr::vector<ComponentDependencySlot>& m_vSlots;
+    ComponentBase* m_pDeclarer;
+};
+
+#endif // COMPONENT_DEPENDENCY_HPP
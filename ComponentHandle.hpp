@@ -0,0 +1,71 @@
+﻿#ifndef COMPONENT_HANDLE_HPP
+#define COMPONENT_HANDLE_HPP
+
+#include <cstdint>
+
+#include "ComponentPool.hpp"
+#include "ObjectHandle.hpp"
+#include "RefCountPolicy.hpp"
+
+
+
+// コンポーネントを参照するためのハンドル (型ごとのプール + オブジェクト番号 + 世代)
+// GameObject::GetComponentHandle で一度取得しておけば、以降は世代の比較だけでコンポーネントを取得できる
+// (weak_ptr の lock() のアトミック操作や、dynamic_pointer_cast が要らない)
+// コンポーネントが削除・置き換えられたり、持ち主が削除されると世代が進み、Get() が nullptr を返すようになる
+// プールは ObjectManager が所有しているため、ObjectManager より長く持たないこと
+template<typename CompType>
+class ComponentHandle
+{
+public:
+    ComponentHandle() = default;
+
+    ComponentHandle(ComponentPool<SharedPtr<CompType>>* a_pPool,ObjectIndex a_index,std::uint32_t a_generation)
+        : m_pPool(a_pPool)
+        , m_index(a_index)
+        , m_generation(a_generation)
+    {
+    }
+
+    // 指しているコンポーネントを取得する (既に削除されていればnullptr)
+    // 参照カウントを操作しないため、返したポインタはコンポーネントが削除されるまでの間だけ使うこと
+    CompType* Get() const
+    {
+        if(m_pPool == nullptr)
+        {
+            return nullptr;
+        }
+        SharedPtr<CompType>* pspComp = m_pPool->Find(m_index,m_generation);
+        return pspComp != nullptr ? pspComp->get() : nullptr;
+    }
+
+    CompType* operator->() const
+    {
+        return Get();
+    }
+
+    // 指しているコンポーネントがまだ存在しているか
+    bool IsValid() const
+    {
+        return Get() != nullptr;
+    }
+
+    // 何も指していないか (有効かどうかは IsValid で調べる)
+    bool IsNull() const
+    {
+        return m_pPool == nullptr;
+    }
+
+    // 持ち主のオブジェクトの番号
+    ObjectIndex GetObjectIndex() const
+    {
+        return m_index;
+    }
+
+private:
+    ComponentPool<SharedPtr<CompType>>* m_pPool = nullptr;
+    ObjectIndex m_index = INVALID_OBJECT_INDEX;
+    std::uint32_t m_generation = 0;
+};
+
+#endif // COMPONENT_HANDLE_HPP
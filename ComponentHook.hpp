@@ -0,0 +1,140 @@
+﻿#ifndef COMPONENT_HOOK_HPP
+#define COMPONENT_HOOK_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+
+
+// 前方宣言
+class ComponentBase;
+class UpdateContext;
+
+
+// コンポーネントが実装している処理を表すビットの組み合わせ
+using ComponentHookMask = std::uint8_t;
+
+constexpr ComponentHookMask HOOK_NONE        = 0;
+constexpr ComponentHookMask HOOK_START       = 1 << 0; // OnStart
+constexpr ComponentHookMask HOOK_PRE_UPDATE  = 1 << 1; // OnPreUpdate
+constexpr ComponentHookMask HOOK_UPDATE      = 1 << 2; // OnUpdate
+constexpr ComponentHookMask HOOK_POST_UPDATE = 1 << 3; // OnPostUpdate
+constexpr ComponentHookMask HOOK_ALL         = HOOK_START | HOOK_PRE_UPDATE | HOOK_UPDATE | HOOK_POST_UPDATE;
+
+
+// 処理ごとにコンポーネントをまとめて呼ぶときの処理の番号
+enum ComponentHookList : std::size_t
+{
+    HOOK_LIST_START,
+    HOOK_LIST_PRE_UPDATE,
+    HOOK_LIST_UPDATE,
+    HOOK_LIST_POST_UPDATE,
+    HOOK_LIST_COUNT,
+};
+
+// 処理の番号に対応するビット
+constexpr ComponentHookMask HOOK_LIST_MASKS[HOOK_LIST_COUNT] = { HOOK_START,HOOK_PRE_UPDATE,HOOK_UPDATE,HOOK_POST_UPDATE };
+
+
+// コンポーネントの型がどの処理をオーバーライドしているかをコンパイル時に調べる仕組み
+// &CompType::OnUpdate の型は、その関数を宣言したクラスのメンバ関数ポインタになるため、
+// ComponentBase のものならオーバーライドしていないと分かる
+// 引数無しと UpdateContext を受け取るものの、どちらかをオーバーライドしていればその処理を実装しているとみなす
+namespace ComponentHookDetail
+{
+    template<typename ClassType>
+    ClassType* DeclaringClass(void (ClassType::*)());
+    template<typename ClassType>
+    ClassType* DeclaringClassWithContext(void (ClassType::*)(const UpdateContext&));
+
+    // 関数が private や、派生クラスでもう一方だけをオーバーライドして隠れているなどで取得できない場合は、
+    // オーバーライドしているものとして扱う
+    // CanCallDirect～WithContext は CompType::OnUpdate(ctx) のように仮想関数を経由せず直接呼べるか
+#define COMPONENT_HOOK_DETECTOR(HookName)                                                       \
+    template<typename CompType,typename = void>                                                 \
+    struct Overrides##HookName##NoContext : std::true_type {};                                  \
+    template<typename CompType>                                                                 \
+    struct Overrides##HookName##NoContext<CompType,std::void_t<decltype(DeclaringClass(&CompType::HookName))>> \
+        : std::bool_constant<!std::is_same<decltype(DeclaringClass(&CompType::HookName)),ComponentBase*>::value> {}; \
+    template<typename CompType,typename = void>                                                 \
+    struct Overrides##HookName##WithContext : std::true_type {};                                \
+    template<typename CompType>                                                                 \
+    struct Overrides##HookName##WithContext<CompType,std::void_t<decltype(DeclaringClassWithContext(&CompType::HookName))>> \
+        : std::bool_constant<!std::is_same<decltype(DeclaringClassWithContext(&CompType::HookName)),ComponentBase*>::value> {}; \
+    template<typename CompType>                                                                 \
+    struct Overrides##HookName                                                                  \
+        : std::bool_constant<Overrides##HookName##NoContext<CompType>::value || Overrides##HookName##WithContext<CompType>::value> {}; \
+    template<typename CompType,typename = void>                                                 \
+    struct CanCallDirect##HookName##WithContext : std::false_type {};                           \
+    template<typename CompType>                                                                 \
+    struct CanCallDirect##HookName##WithContext<CompType,                                       \
+        std::void_t<decltype(std::declval<CompType&>().CompType::HookName(std::declval<const UpdateContext&>()))>> \
+        : std::true_type {};
+
+    COMPONENT_HOOK_DETECTOR(OnStart)
+    COMPONENT_HOOK_DETECTOR(OnPreUpdate)
+    COMPONENT_HOOK_DETECTOR(OnUpdate)
+    COMPONENT_HOOK_DETECTOR(OnPostUpdate)
+#undef COMPONENT_HOOK_DETECTOR
+
+    // コンポーネントが static constexpr ComponentHookMask HOOK_MASK を宣言しているか
+    template<typename CompType,typename = void>
+    struct HasHookMask : std::false_type {};
+    template<typename CompType>
+    struct HasHookMask<CompType,std::void_t<decltype(CompType::HOOK_MASK)>> : std::true_type {};
+
+    // コンポーネントが static constexpr bool THREAD_SAFE = true を宣言しているか
+    template<typename CompType,typename = void>
+    struct IsThreadSafe : std::false_type {};
+    template<typename CompType>
+    struct IsThreadSafe<CompType,std::void_t<decltype(CompType::THREAD_SAFE)>> : std::bool_constant<CompType::THREAD_SAFE> {};
+
+    // コンポーネントが static constexpr bool MAIN_THREAD_DESTROY = true を宣言しているか
+    template<typename CompType,typename = void>
+    struct IsMainThreadDestroy : std::false_type {};
+    template<typename CompType>
+    struct IsMainThreadDestroy<CompType,std::void_t<decltype(CompType::MAIN_THREAD_DESTROY)>> : std::bool_constant<CompType::MAIN_THREAD_DESTROY> {};
+}
+
+// コンポーネントの型が実装している処理のビットの組み合わせを求める
+// コンポーネントが static constexpr ComponentHookMask HOOK_MASK を宣言していればそれを使う
+template<typename CompType>
+constexpr ComponentHookMask GetComponentHookMask()
+{
+    if constexpr(ComponentHookDetail::HasHookMask<CompType>::value)
+    {
+        return CompType::HOOK_MASK;
+    }
+    else
+    {
+        return static_cast<ComponentHookMask>(
+            (ComponentHookDetail::OverridesOnStart<CompType>::value      ? HOOK_START       : HOOK_NONE) |
+            (ComponentHookDetail::OverridesOnPreUpdate<CompType>::value  ? HOOK_PRE_UPDATE  : HOOK_NONE) |
+            (ComponentHookDetail::OverridesOnUpdate<CompType>::value     ? HOOK_UPDATE      : HOOK_NONE) |
+            (ComponentHookDetail::OverridesOnPostUpdate<CompType>::value ? HOOK_POST_UPDATE : HOOK_NONE));
+    }
+}
+
+// コンポーネントの処理を複数のスレッドから同時に呼んで良いか
+// static constexpr bool THREAD_SAFE = true; を宣言したコンポーネントだけが対象になる
+// 宣言できるのは、OnPreUpdate/OnUpdate/OnPostUpdate が自身のデータだけを書き換え、
+// コンポーネントやオブジェクトの追加/削除、SetActive などを行わない型に限る
+template<typename CompType>
+constexpr bool IsThreadSafeComponent()
+{
+    return ComponentHookDetail::IsThreadSafe<CompType>::value;
+}
+
+// コンポーネントをメインスレッドで破棄しなければならないか
+// ObjectManager::SetBackgroundDestroy で破棄を別のスレッドで行うとき、
+// static constexpr bool MAIN_THREAD_DESTROY = true; を宣言した型はメインスレッドで破棄する
+// デストラクタがメインスレッドでしか触れない資源(描画APIのリソースなど)を解放する型に宣言する
+template<typename CompType>
+constexpr bool IsMainThreadDestroyComponent()
+{
+    return ComponentHookDetail::IsMainThreadDestroy<CompType>::value;
+}
+
+#endif // COMPONENT_HOOK_HPP
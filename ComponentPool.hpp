@@ -0,0 +1,446 @@
+﻿#ifndef COMPONENT_POOL_HPP
+#define COMPONENT_POOL_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <tuple>
+#include <new>
+#include <functional>
+#include <atomic>
+
+#include "ComponentTypeRegistry.hpp"
+#include "ComponentHook.hpp"
+#include "ObjectHandle.hpp"
+#include "RefCountPolicy.hpp"
+#include "UpdateContext.hpp"
+
+
+// 型ごとのプールの基底クラス (型を知らずに削除できるようにする)
+class ComponentPoolBase
+{
+public:
+    virtual ~ComponentPoolBase() = default;
+
+    // 引数の番号のオブジェクトの値を削除する
+    virtual void Remove(ObjectIndex a_index) = 0;
+
+    // 引数の番号のオブジェクトの値を持っているか
+    virtual bool Has(ObjectIndex a_index) const = 0;
+
+    // 格納している値の数
+    virtual std::size_t GetCount() const = 0;
+};
+
+
+// 1つの型の値をオブジェクト番号と紐づけて格納するスパースセット
+// 値は隙間なく詰めた配列(dense)に並び、オブジェクト番号からその位置を引く配列(sparse)を別に持つ
+// 追加・削除・検索は全てO(1)で、削除は末尾の値を空いた位置へ移動して詰める
+// Lock() 中の削除は値を残したまま無効の印を付けるだけにして、Unlock() でまとめて詰める
+// (dense を先頭から辿っている最中に要素の並びが変わらないようにするため)
+template<typename ValueType>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+    // 値を追加する (既に持っていれば作り直す)
+    template<typename...ArgTypes>
+    ValueType& Insert(ObjectIndex a_index,ArgTypes&&... a_args)
+    {
+        if(a_index >= m_vSparse.size())
+        {
+            m_vSparse.resize(static_cast<std::size_t>(a_index) + 1,SparseEntry{ INVALID_DENSE,0 });
+        }
+
+        // 値の型にはムーブ構築だけを求めるため、代入ではなく破棄して構築し直す
+        // 別の値に置き換わるので、前の値を指していたハンドルは無効にする
+        std::uint32_t dense = m_vSparse[a_index].dense;
+        if(dense != INVALID_DENSE)
+        {
+            ++m_vSparse[a_index].generation;
+            ValueType value(std::forward<ArgTypes>(a_args)...);
+            ValueType* pValue = &m_vDense[dense];
+            pValue->~ValueType();
+            return *new(pValue) ValueType(std::move(value));
+        }
+
+        m_vSparse[a_index].dense = static_cast<std::uint32_t>(m_vDense.size());
+        m_vDenseToIndex.push_back(a_index);
+        m_vDense.emplace_back(std::forward<ArgTypes>(a_args)...);
+        return m_vDense.back();
+    }
+
+    // 値を削除する (末尾の値を削除した位置へ移動する)
+    void Remove(ObjectIndex a_index) override
+    {
+        if(!Has(a_index))
+        {
+            return;
+        }
+
+        std::uint32_t dense = m_vSparse[a_index].dense;
+        m_vSparse[a_index].dense = INVALID_DENSE;
+        ++m_vSparse[a_index].generation;
+
+        // 辿っている最中なら印を付けるだけにして、値はUnlock()まで残しておく
+        if(m_lockCount > 0)
+        {
+            m_vDenseToIndex[dense] = INVALID_OBJECT_INDEX;
+            m_vPendingRemove.push_back(dense);
+            return;
+        }
+
+        EraseDense(dense);
+    }
+
+    bool Has(ObjectIndex a_index) const override
+    {
+        return a_index < m_vSparse.size() && m_vSparse[a_index].dense != INVALID_DENSE;
+    }
+
+    std::size_t GetCount() const override
+    {
+        return m_vDense.size() - m_vPendingRemove.size();
+    }
+
+    // dense を辿り始める前に呼ぶ (入れ子にできる)
+    void Lock()
+    {
+        ++m_lockCount;
+    }
+
+    // dense を辿り終えたら呼ぶ (Lock中に削除された値をここでまとめて詰める)
+    void Unlock()
+    {
+        if(--m_lockCount > 0 || m_vPendingRemove.empty())
+        {
+            return;
+        }
+
+        // 後ろの位置から詰めれば、末尾から移動してくる値が削除待ちであることは無い
+        std::sort(m_vPendingRemove.begin(),m_vPendingRemove.end(),std::greater<std::uint32_t>());
+        for(std::uint32_t dense : m_vPendingRemove)
+        {
+            EraseDense(dense);
+        }
+        m_vPendingRemove.clear();
+    }
+
+    // dense の引数の位置の値が有効か (Lock中に削除されたものは無効)
+    bool IsAlive(std::size_t a_dense) const
+    {
+        return m_vDenseToIndex[a_dense] != INVALID_OBJECT_INDEX;
+    }
+
+    // 値を取得する (持っていなければnullptr)
+    // 追加・削除で値の位置が変わるため、返したポインタを保持し続けないこと
+    ValueType* Find(ObjectIndex a_index)
+    {
+        if(!Has(a_index))
+        {
+            return nullptr;
+        }
+        return &m_vDense[m_vSparse[a_index].dense];
+    }
+
+    // 引数の世代のときに格納された値を取得する (削除・置き換え済みならnullptr)
+    // ComponentHandle から使う
+    ValueType* Find(ObjectIndex a_index,std::uint32_t a_generation)
+    {
+        if(a_index >= m_vSparse.size())
+        {
+            return nullptr;
+        }
+        const SparseEntry& entry = m_vSparse[a_index];
+        if(entry.dense == INVALID_DENSE || entry.generation != a_generation)
+        {
+            return nullptr;
+        }
+        return &m_vDense[entry.dense];
+    }
+
+    // 引数の番号のオブジェクトの値の世代 (値が削除・置き換えられるたびに進む)
+    std::uint32_t GetGeneration(ObjectIndex a_index) const
+    {
+        return a_index < m_vSparse.size() ? m_vSparse[a_index].generation : 0;
+    }
+
+    // 隙間なく並んだ値の配列 (先頭から順に辿ることで全ての値を処理できる)
+    std::vector<ValueType>& GetDense()
+    {
+        return m_vDense;
+    }
+
+    // GetDense() の各要素に対応するオブジェクト番号 (Lock中に削除されたものは INVALID_OBJECT_INDEX)
+    const std::vector<ObjectIndex>& GetDenseIndices() const
+    {
+        return m_vDenseToIndex;
+    }
+
+private:
+    // dense の引数の位置の値を削除し、末尾の値をそこへ移動する
+    void EraseDense(std::uint32_t a_dense)
+    {
+        std::uint32_t last = static_cast<std::uint32_t>(m_vDense.size() - 1);
+        if(a_dense != last)
+        {
+            ValueType* pValue = &m_vDense[a_dense];
+            pValue->~ValueType();
+            new(pValue) ValueType(std::move(m_vDense[last]));
+            m_vDenseToIndex[a_dense] = m_vDenseToIndex[last];
+            if(m_vDenseToIndex[a_dense] != INVALID_OBJECT_INDEX)
+            {
+                m_vSparse[m_vDenseToIndex[a_dense]].dense = a_dense;
+            }
+        }
+        m_vDense.pop_back();
+        m_vDenseToIndex.pop_back();
+    }
+
+private:
+    // sparse 側で値を持っていないことを表す値
+    static constexpr std::uint32_t INVALID_DENSE = static_cast<std::uint32_t>(-1);
+
+    // Lock() の入れ子の深さと、Lock中に削除された dense の位置
+    // 同じ型を読むだけのシステムが複数のスレッドから同時にLockするため、深さはアトミックにする
+    std::atomic<int> m_lockCount{ 0 };
+    std::vector<std::uint32_t> m_vPendingRemove;
+
+    // オブジェクト番号ごとの、dense の位置と値の世代
+    struct SparseEntry
+    {
+        std::uint32_t dense;
+        std::uint32_t generation;
+    };
+
+    // オブジェクト番号 → dense の位置
+    std::vector<SparseEntry> m_vSparse;
+
+    // 値と、その値を持つオブジェクト番号 (同じ位置同士が対応する)
+    std::vector<ValueType> m_vDense;
+    std::vector<ObjectIndex> m_vDenseToIndex;
+};
+
+
+class ThreadPool;
+
+// 1つのプールに格納されたコンポーネント全てに、引数の処理をまとめて呼ぶ関数
+// 呼んでいる間のプールのLock/Unlockもこの関数が行う
+// スレッドプールを渡すとプールを範囲に分けて複数のスレッドで呼ぶ (nullptrなら呼び出し元のスレッドだけで呼ぶ)
+// a_frame は各コンポーネントの処理に渡す UpdateContext の元になる
+using ComponentHookDispatchFunc = void(*)(ComponentPoolBase& a_pool,ComponentHookList a_list,const FrameContext& a_frame,ThreadPool* a_pThreadPool);
+
+// 処理をまとめて呼ぶプールと、そのプールのコンポーネントが実装している処理
+struct ComponentHookDispatcher
+{
+    ComponentPoolBase* pPool;
+    ComponentHookMask hookMask;
+    bool isThreadSafe; // 複数のスレッドから呼んで良い型か
+    ComponentHookDispatchFunc pfnDispatch;
+};
+
+
+// コンポーネントやオブジェクトの追加/削除を、現在のスレッドで一時的に禁止する
+// 他の処理と同時に実行している間に追加/削除を行うと、コンポーネントの配列やプールを同時に書き換えてしまうため、
+// SystemScheduler が SystemStructuralChange を宣言していないシステムを呼ぶ間だけ禁止する
+// 禁止されている間の追加/削除は、デバッグビルドでは assert で止まる (IsLocked で確認する)
+class StructuralChangeLock
+{
+public:
+    explicit StructuralChangeLock(bool a_isLock)
+        : m_isPrevLocked(GetLockedFlag())
+    {
+        GetLockedFlag() = m_isPrevLocked || a_isLock;
+    }
+
+    ~StructuralChangeLock()
+    {
+        GetLockedFlag() = m_isPrevLocked;
+    }
+
+    StructuralChangeLock(const StructuralChangeLock&) = delete;
+    StructuralChangeLock& operator=(const StructuralChangeLock&) = delete;
+
+    // 現在のスレッドで追加/削除が禁止されているか
+    static bool IsLocked()
+    {
+        return GetLockedFlag();
+    }
+
+private:
+    static bool& GetLockedFlag()
+    {
+        static thread_local bool s_isLocked = false;
+        return s_isLocked;
+    }
+
+    bool m_isPrevLocked;
+};
+
+
+// コンポーネントの型IDごとのプールをまとめて持つクラス
+// ObjectManagerが所有し、GameObjectの型指定の Add/Get/Remove/HasComponent から使われる
+class ComponentPools
+{
+public:
+    // 通常のコンポーネント(ComponentBase の派生)の値を格納するプールを取得する
+    // 無ければ作成し、ObjectManager が型ごとにまとめて処理を呼べるよう関数を登録する
+    template<typename ValueType>
+    ComponentPool<ValueType>& GetHookedPool(ComponentTypeID a_id,ComponentHookMask a_hookMask,bool a_isThreadSafe,ComponentHookDispatchFunc a_pfnDispatch)
+    {
+        bool isNew = FindPoolBase(a_id) == nullptr;
+        ComponentPool<ValueType>& pool = GetPool<ValueType>(a_id);
+        if(isNew && a_hookMask != HOOK_NONE)
+        {
+            m_vHookDispatchers.push_back(ComponentHookDispatcher{ &pool,a_hookMask,a_isThreadSafe,a_pfnDispatch });
+        }
+        return pool;
+    }
+
+    // 文字列版のAddComponentで追加されたコンポーネントのプールを取得する (無ければ作成する)
+    // 型が分からないため ComponentBase のまま格納し、型IDごとに別のプールにする
+    ComponentPool<SharedPtr<ComponentBase>>& GetUntypedPool(ComponentTypeID a_id,ComponentHookDispatchFunc a_pfnDispatch)
+    {
+        if(a_id >= m_vUntypedPools.size())
+        {
+            m_vUntypedPools.resize(static_cast<std::size_t>(a_id) + 1);
+        }
+        if(m_vUntypedPools[a_id] == nullptr)
+        {
+            m_vUntypedPools[a_id] = std::make_unique<ComponentPool<SharedPtr<ComponentBase>>>();
+            m_vHookDispatchers.push_back(ComponentHookDispatcher{ m_vUntypedPools[a_id].get(),HOOK_ALL,false,a_pfnDispatch });
+        }
+        return static_cast<ComponentPool<SharedPtr<ComponentBase>>&>(*m_vUntypedPools[a_id]);
+    }
+
+    ComponentPoolBase* FindUntypedPoolBase(ComponentTypeID a_id)
+    {
+        if(a_id >= m_vUntypedPools.size())
+        {
+            return nullptr;
+        }
+        return m_vUntypedPools[a_id].get();
+    }
+
+    // 処理をまとめて呼ぶプールの一覧 (プールが作られた順)
+    const std::vector<ComponentHookDispatcher>& GetHookDispatchers() const
+    {
+        return m_vHookDispatchers;
+    }
+
+    // 引数のIDのプールを取得する (無ければ作成する)
+    // 同じIDには常に同じ ValueType を使うこと
+    template<typename ValueType>
+    ComponentPool<ValueType>& GetPool(ComponentTypeID a_id)
+    {
+        if(a_id >= m_vPools.size())
+        {
+            m_vPools.resize(static_cast<std::size_t>(a_id) + 1);
+        }
+        if(m_vPools[a_id] == nullptr)
+        {
+            m_vPools[a_id] = std::make_unique<ComponentPool<ValueType>>();
+        }
+        return static_cast<ComponentPool<ValueType>&>(*m_vPools[a_id]);
+    }
+
+    // 引数のIDのプールを取得する (無ければnullptr)
+    template<typename ValueType>
+    ComponentPool<ValueType>* FindPool(ComponentTypeID a_id)
+    {
+        return static_cast<ComponentPool<ValueType>*>(FindPoolBase(a_id));
+    }
+
+    ComponentPoolBase* FindPoolBase(ComponentTypeID a_id)
+    {
+        if(a_id >= m_vPools.size())
+        {
+            return nullptr;
+        }
+        return m_vPools[a_id].get();
+    }
+
+    // 引数のオブジェクトの値を全てのプールから削除する
+    void RemoveAll(ObjectIndex a_index)
+    {
+        for(const std::unique_ptr<ComponentPoolBase>& upPool : m_vPools)
+        {
+            if(upPool)
+            {
+                upPool->Remove(a_index);
+            }
+        }
+        for(const std::unique_ptr<ComponentPoolBase>& upPool : m_vUntypedPools)
+        {
+            if(upPool)
+            {
+                upPool->Remove(a_index);
+            }
+        }
+    }
+
+    // 引数の型の値を全て持つオブジェクトに対して関数を呼ぶ
+    // 最初の型のプールを先頭から辿り、残りの型はオブジェクト番号から引く
+    // 辿っている間はプールをLockするため、関数の中で値を削除しても良い (値の追加はしないこと)
+    template<typename...ValueTypes,typename Func>
+    void ForEach(Func&& a_func)
+    {
+        ForEachImpl<ValueTypes...>(a_func);
+    }
+
+private:
+    template<typename FirstType,typename...RestTypes,typename Func>
+    void ForEachImpl(Func& a_func)
+    {
+        ComponentPool<FirstType>* pFirst = FindPool<FirstType>(ComponentTypeRegistry::GetID<FirstType>());
+        if(pFirst == nullptr)
+        {
+            return;
+        }
+
+        std::tuple<ComponentPool<RestTypes>*...> restPools(FindPool<RestTypes>(ComponentTypeRegistry::GetID<RestTypes>())...);
+        if(std::apply([](auto*... a_pPools) { return ((a_pPools == nullptr) || ...); },restPools))
+        {
+            return;
+        }
+
+        pFirst->Lock();
+        std::apply([](auto*... a_pPools) { (a_pPools->Lock(),...); },restPools);
+
+        std::vector<FirstType>& vDense = pFirst->GetDense();
+        const std::vector<ObjectIndex>& vIndices = pFirst->GetDenseIndices();
+        for(std::size_t i = 0; i < vDense.size(); ++i)
+        {
+            // 辿っている最中に削除されたものは飛ばす
+            ObjectIndex index = vIndices[i];
+            if(index == INVALID_OBJECT_INDEX)
+            {
+                continue;
+            }
+            std::apply([&](auto*... a_pPools)
+                {
+                    if(((a_pPools->Has(index)) && ...))
+                    {
+                        a_func(vDense[i],*a_pPools->Find(index)...);
+                    }
+                },restPools);
+        }
+
+        std::apply([](auto*... a_pPools) { (a_pPools->Unlock(),...); },restPools);
+        pFirst->Unlock();
+    }
+
+private:
+    // 型IDを添え字としたプールの配列
+    std::vector<std::unique_ptr<ComponentPoolBase>> m_vPools;
+
+    // 文字列版のAddComponentで追加されたコンポーネントの、型IDを添え字としたプールの配列
+    std::vector<std::unique_ptr<ComponentPoolBase>> m_vUntypedPools;
+
+    // 処理をまとめて呼ぶプールの一覧 (プールは破棄されないのでポインタを持つ)
+    std::vector<ComponentHookDispatcher> m_vHookDispatchers;
+};
+
+#endif // COMPONENT_POOL_HPP
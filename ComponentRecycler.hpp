@@ -0,0 +1,163 @@
+﻿#ifndef COMPONENT_RECYCLER_HPP
+#define COMPONENT_RECYCLER_HPP
+
+#include <vector>
+#include <memory>
+#include <typeinfo>
+#include <cstddef>
+
+#include "ComponentTypeRegistry.hpp"
+#include "RefCountPolicy.hpp"
+
+
+
+// 前方宣言
+class ComponentBase;
+
+
+// 1つの型の、再利用を待っているコンポーネントを溜めておく入れ物の基底クラス
+class ComponentRecyclePoolBase
+{
+public:
+    virtual ~ComponentRecyclePoolBase() = default;
+
+    // 引数のコンポーネントを溜められれば OnReset を呼んで引数から移し、true を返す
+    virtual bool Recycle(SharedPtr<ComponentBase>& a_spComp) = 0;
+
+    // 上限を超えた分を破棄する
+    virtual void Trim() = 0;
+
+    // 溜めておく数の上限
+    std::size_t capacity = 0;
+};
+
+
+// 1つの型の、再利用を待っているコンポーネントを溜めておく入れ物
+template<typename CompType>
+class ComponentRecyclePool : public ComponentRecyclePoolBase
+{
+public:
+    bool Recycle(SharedPtr<ComponentBase>& a_spComp) override
+    {
+        // 溢れる場合や、他に参照が残っている場合は再利用しない (通常通り破棄される)
+        if(m_vComps.size() >= capacity || a_spComp.use_count() != 1)
+        {
+            return false;
+        }
+        // 文字列版のAddComponentで同じIDに別の型が登録されていることがあるので、型が一致するものだけ溜める
+        // (ComponentBase はここではまだ定義されていないため、CompType を通して扱う)
+        CompType* pComp = dynamic_cast<CompType*>(a_spComp.get());
+        if(pComp == nullptr || typeid(*pComp) != typeid(CompType))
+        {
+            return false;
+        }
+        pComp->OnReset();
+        m_vComps.push_back(StaticPointerCast<CompType>(std::move(a_spComp)));
+        return true;
+    }
+
+    // 溜めているコンポーネントを1つ取り出す (無ければnullptr)
+    SharedPtr<CompType> Take()
+    {
+        if(m_vComps.empty())
+        {
+            return nullptr;
+        }
+        SharedPtr<CompType> spComp = std::move(m_vComps.back());
+        m_vComps.pop_back();
+        return spComp;
+    }
+
+    void Trim() override
+    {
+        if(m_vComps.size() > capacity)
+        {
+            m_vComps.resize(capacity);
+        }
+    }
+
+private:
+    std::vector<SharedPtr<CompType>> m_vComps;
+};
+
+
+// 破棄されるコンポーネントを型ごとに溜めておき、同じ型の AddComponent で再利用するクラス
+// 確保と解放を繰り返さずに済むので、生成と破棄を頻繁に繰り返す型(弾やパーティクルなど)に使う
+// SetCapacity で上限をセットした型だけが対象になる (既定では何も溜めない)
+class ComponentRecycler
+{
+public:
+    // 引数の型のコンポーネントを溜めておく数の上限をセットする (0 で溜めたものも破棄する)
+    template<typename CompType>
+    void SetCapacity(std::size_t a_capacity)
+    {
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        if(id >= m_vPools.size())
+        {
+            m_vPools.resize(static_cast<std::size_t>(id) + 1);
+        }
+        if(m_vPools[id] == nullptr)
+        {
+            m_vPools[id] = std::make_unique<ComponentRecyclePool<CompType>>();
+        }
+        ComponentRecyclePool<CompType>& pool = static_cast<ComponentRecyclePool<CompType>&>(*m_vPools[id]);
+        pool.capacity = a_capacity;
+        pool.Trim();
+    }
+
+    // 引数の型の溜めているコンポーネントを1つ取り出す (無ければnullptr)
+    template<typename CompType>
+    SharedPtr<CompType> Take()
+    {
+        ComponentTypeID id = ComponentTypeRegistry::GetID<CompType>();
+        if(id >= m_vPools.size() || m_vPools[id] == nullptr)
+        {
+            return nullptr;
+        }
+        return static_cast<ComponentRecyclePool<CompType>&>(*m_vPools[id]).Take();
+    }
+
+    // 引数のIDのコンポーネントを溜められれば引数から移し、true を返す
+    bool Recycle(ComponentTypeID a_id,SharedPtr<ComponentBase>& a_spComp)
+    {
+        if(a_id >= m_vPools.size() || m_vPools[a_id] == nullptr)
+        {
+            return false;
+        }
+        return m_vPools[a_id]->Recycle(a_spComp);
+    }
+
+    // 上限が1以上の型があるか (無ければ再利用は行われない)
+    bool HasCapacity() const
+    {
+        for(const std::unique_ptr<ComponentRecyclePoolBase>& upPool : m_vPools)
+        {
+            if(upPool && upPool->capacity > 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 溜めているものを全て破棄する (上限はそのまま)
+    void Clear()
+    {
+        for(std::unique_ptr<ComponentRecyclePoolBase>& upPool : m_vPools)
+        {
+            if(upPool)
+            {
+                std::size_t capacity = upPool->capacity;
+                upPool->capacity = 0;
+                upPool->Trim();
+                upPool->capacity = capacity;
+            }
+        }
+    }
+
+private:
+    // 型IDを添え字とした、型ごとの入れ物
+    std::vector<std::unique_ptr<ComponentRecyclePoolBase>> m_vPools;
+};
+
+#endif // COMPONENT_RECYCLER_HPP
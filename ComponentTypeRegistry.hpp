@@ -0,0 +1,97 @@
+﻿#ifndef COMPONENT_TYPE_REGISTRY_HPP
+#define COMPONENT_TYPE_REGISTRY_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <deque>
+#include <typeinfo> // typeid のために必要
+#include <cstdint>
+
+
+// コンポーネントの型ごとに割り振られる連番のID
+using ComponentTypeID = std::uint32_t;
+
+// 無効なコンポーネントIDを表す値
+constexpr ComponentTypeID INVALID_COMPONENT_TYPE_ID = static_cast<ComponentTypeID>(-1);
+
+// コンポーネントの型(または名前)に連番のIDを割り振るレジストリ
+// 型ごとのIDは最初の一回だけ名前から登録され、以降は静的変数を返すだけになる
+class ComponentTypeRegistry
+{
+public:
+    // 型からIDを取得する (テンプレート版)
+    // 文字列の生成やハッシュ計算は初回呼び出し時の一度だけ
+    template<typename CompType>
+    static ComponentTypeID GetID()
+    {
+        // typeid(CompType).name() で登録しておくことで、文字列版のAddComponentとも同じIDを共有できる
+        static const ComponentTypeID s_id = GetID(typeid(CompType).name());
+        return s_id;
+    }
+
+    // 名前からIDを取得する (未登録の名前なら新しいIDを割り振る)
+    static ComponentTypeID GetID(std::string_view a_name)
+    {
+        NameToIDMap& umNameToID = GetNameToID();
+
+        auto itr = umNameToID.find(a_name);
+        if(itr != umNameToID.end())
+        {
+            return itr->second;
+        }
+
+        // 新しいIDは登録済みの数をそのまま使う (0から詰めて割り振られる)
+        // キーは登録した名前の文字列を指すので、先に名前を保存してから登録する
+        ComponentTypeID newID = static_cast<ComponentTypeID>(GetIDToName().size());
+        const std::string& name = GetIDToName().emplace_back(a_name);
+        umNameToID.emplace(name,newID);
+        return newID;
+    }
+
+    // 名前からIDを検索する (未登録の名前なら INVALID_COMPONENT_TYPE_ID を返し、登録はしない)
+    static ComponentTypeID FindID(std::string_view a_name)
+    {
+        NameToIDMap& umNameToID = GetNameToID();
+
+        auto itr = umNameToID.find(a_name);
+        if(itr == umNameToID.end())
+        {
+            return INVALID_COMPONENT_TYPE_ID;
+        }
+        return itr->second;
+    }
+
+    // IDから登録時の名前を取得する (デバッグ表示用)
+    static const std::string& GetName(ComponentTypeID a_id)
+    {
+        return GetIDToName()[a_id];
+    }
+
+    // 登録済みのIDの数
+    static std::size_t GetCount()
+    {
+        return GetIDToName().size();
+    }
+
+private:
+    // 名前からIDを引くコンテナ
+    // キーは GetIDToName() に保存した名前を指すので、検索のたびに文字列を作らずに済む
+    using NameToIDMap = std::unordered_map<std::string_view,ComponentTypeID>;
+
+    // 静的変数の初期化順の問題を避けるため、関数内の静的変数として持つ
+    static NameToIDMap& GetNameToID()
+    {
+        static NameToIDMap s_umNameToID;
+        return s_umNameToID;
+    }
+
+    // 返した参照と NameToIDMap のキーが無効にならないように deque で持つ
+    static std::deque<std::string>& GetIDToName()
+    {
+        static std::deque<std::string> s_dqIDToName;
+        return s_dqIDToName;
+    }
+};
+
+#endif // COMPONENT_TYPE_REGISTRY_HPP
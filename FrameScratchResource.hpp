@@ -0,0 +1,123 @@
+﻿#ifndef FRAME_SCRATCH_RESOURCE_HPP
+#define FRAME_SCRATCH_RESOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <memory_resource>
+
+
+
+// 1フレームの間だけ使う一時的なメモリを切り出すメモリリソース
+// 塊の先頭から順に切り出すだけで個別の解放は行わず、Reset でまとめて無かったことにする
+// 切り出す位置をアトミックに進めるので、THREAD_SAFE の型の処理から同時に確保しても良い
+// 塊が足りなくなったフレームは上流のメモリリソースから確保し、次の Reset で塊をそのフレームで使った大きさまで広げる
+class FrameScratchResource : public std::pmr::memory_resource
+{
+public:
+    explicit FrameScratchResource(std::size_t a_initialSize = 64 * 1024,
+        std::pmr::memory_resource* a_pUpstream = std::pmr::get_default_resource())
+        : m_pUpstream(a_pUpstream)
+    {
+        AllocateBuffer(a_initialSize);
+    }
+
+    ~FrameScratchResource() override
+    {
+        ReleaseOverflow();
+        m_pUpstream->deallocate(m_pBuffer,m_capacity,alignof(std::max_align_t));
+    }
+
+    FrameScratchResource(const FrameScratchResource&) = delete;
+    FrameScratchResource& operator=(const FrameScratchResource&) = delete;
+
+    // 切り出したメモリを全て無かったことにする (確保している処理が無いときに、メインスレッドから呼ぶ)
+    void Reset()
+    {
+        std::size_t used = m_used.load(std::memory_order_relaxed);
+        ReleaseOverflow();
+        if(used > m_capacity)
+        {
+            m_pUpstream->deallocate(m_pBuffer,m_capacity,alignof(std::max_align_t));
+            AllocateBuffer(std::max(used,m_capacity * 2));
+        }
+        m_used.store(0,std::memory_order_relaxed);
+    }
+
+    // 塊の大きさ
+    std::size_t GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+private:
+    // 上流から確保したメモリ (Reset で返す)
+    struct Overflow
+    {
+        void* p;
+        std::size_t size;
+        std::size_t align;
+    };
+
+    void* do_allocate(std::size_t a_bytes,std::size_t a_align) override
+    {
+        // 揃える分も含めて予約するので、位置を進めた後で揃えても他と重ならない
+        std::size_t reserve = a_bytes + a_align - 1;
+        std::size_t offset = m_used.fetch_add(reserve,std::memory_order_relaxed);
+        if(offset + reserve <= m_capacity)
+        {
+            std::uintptr_t top = reinterpret_cast<std::uintptr_t>(m_pBuffer) + offset;
+            top = (top + a_align - 1) & ~static_cast<std::uintptr_t>(a_align - 1);
+            return reinterpret_cast<void*>(top);
+        }
+
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        void* p = m_pUpstream->allocate(a_bytes,a_align);
+        m_vOverflows.push_back(Overflow{ p,a_bytes,a_align });
+        return p;
+    }
+
+    // 個別には解放しない (Reset でまとめて解放する)
+    void do_deallocate(void*,std::size_t,std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& a_other) const noexcept override
+    {
+        return this == &a_other;
+    }
+
+    void AllocateBuffer(std::size_t a_size)
+    {
+        m_capacity = a_size;
+        m_pBuffer = static_cast<std::byte*>(m_pUpstream->allocate(m_capacity,alignof(std::max_align_t)));
+    }
+
+    void ReleaseOverflow()
+    {
+        for(const Overflow& overflow : m_vOverflows)
+        {
+            m_pUpstream->deallocate(overflow.p,overflow.size,overflow.align);
+        }
+        m_vOverflows.clear();
+    }
+
+private:
+    std::pmr::memory_resource* m_pUpstream;
+
+    // 切り出す塊と、その大きさ
+    std::byte* m_pBuffer = nullptr;
+    std::size_t m_capacity = 0;
+
+    // 切り出した大きさ (塊から溢れた分も数えるので、次の塊の大きさに使える)
+    std::atomic<std::size_t> m_used{ 0 };
+
+    // 塊から溢れて上流から確保したメモリ
+    std::mutex m_overflowMutex;
+    std::vector<Overflow> m_vOverflows;
+};
+
+#endif // FRAME_SCRATCH_RESOURCE_HPP
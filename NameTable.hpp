@@ -0,0 +1,245 @@
+﻿#ifndef NAME_TABLE_HPP
+#define NAME_TABLE_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <algorithm>
+
+#include "RefCountPolicy.hpp"
+
+
+
+// NameTable に登録された1つの名前 (文字列・ハッシュ値・テーブル内の番号)
+// NameKey が参照カウントで保持するので、テーブルから取り除かれたりテーブルが破棄されても、キーを持っている間は無効にならない
+// 文字列も参照カウントの領域もテーブルのメモリリソースから確保するので、メモリリソースはキーより長く生かすこと
+struct NameAtom
+{
+    NameAtom(std::string_view a_text,std::size_t a_hash,std::uint32_t a_index,std::pmr::memory_resource* a_pMemoryResource)
+        : text(a_text,a_pMemoryResource)
+        , hash(a_hash)
+        , index(a_index)
+    {
+    }
+
+    std::pmr::string text;
+    std::size_t hash;
+    std::uint32_t index;
+};
+
+
+// NameTable に登録された名前を指すキー
+// 同じテーブルの同じ名前は同じ NameAtom を指すので、比較はポインタの比較だけで済み、ハッシュ値も登録時に求めたものを使う
+// 一度 ObjectManager::InternName で取得しておけば、以降は文字列を辿らずにオブジェクトを探せる
+// キーを持っている間はその名前がテーブルから取り除かれない
+class NameKey
+{
+public:
+    NameKey() = default;
+
+    // 何も指していないか
+    bool IsNull() const
+    {
+        return m_spAtom == nullptr;
+    }
+
+    // 名前の文字列 (何も指していなければ空の文字列)
+    // キーを持っている間だけ有効
+    std::string_view GetString() const
+    {
+        return m_spAtom != nullptr ? std::string_view(m_spAtom->text) : std::string_view();
+    }
+
+    // 登録時に求めたハッシュ値
+    std::size_t GetHash() const
+    {
+        return m_spAtom != nullptr ? m_spAtom->hash : 0;
+    }
+
+    // 登録したテーブル内の番号 (テーブルごとに0から詰めて割り振られるので、配列の添え字に使える)
+    std::uint32_t GetIndex() const
+    {
+        return m_spAtom->index;
+    }
+
+    bool operator==(const NameKey& a_other) const
+    {
+        return m_spAtom == a_other.m_spAtom;
+    }
+
+    bool operator!=(const NameKey& a_other) const
+    {
+        return m_spAtom != a_other.m_spAtom;
+    }
+
+    // unordered_map のキーにするときのハッシュ (登録時に求めた値を返すだけ)
+    struct Hash
+    {
+        std::size_t operator()(const NameKey& a_key) const
+        {
+            return a_key.GetHash();
+        }
+    };
+
+private:
+    friend class NameTable;
+
+    explicit NameKey(SharedPtr<const NameAtom> a_spAtom)
+        : m_spAtom(std::move(a_spAtom))
+    {
+    }
+
+    SharedPtr<const NameAtom> m_spAtom;
+};
+
+
+// オブジェクトの名前を1つずつだけ保持するテーブル (名前のインターン)
+// ObjectManager ごとに持ち、番号はテーブルごとに割り振るので、名前からオブジェクトを引く配列の添え字に使える
+// どの NameKey からも参照されなくなった名前は、登録数が前回の整理の2倍に達したときにまとめて取り除き、番号を再利用する
+// (同時に使われている名前の数に比例したメモリしか使わない)
+// ObjectManager と同じく、メインスレッドから呼ぶこと
+class NameTable
+{
+public:
+    // FindIndex で見つからなかったときの番号
+    static constexpr std::uint32_t INVALID_INDEX = UINT32_MAX;
+
+    explicit NameTable(std::pmr::memory_resource* a_pMemoryResource = std::pmr::get_default_resource())
+        : m_umNameToIndex(a_pMemoryResource)
+        , m_vAtoms(a_pMemoryResource)
+        , m_vFreeIndices(a_pMemoryResource)
+    {
+    }
+
+    // 名前を登録し、そのキーを返す (登録済みなら同じキーを返す)
+    NameKey Intern(std::string_view a_name)
+    {
+        auto itr = m_umNameToIndex.find(a_name);
+        if(itr != m_umNameToIndex.end())
+        {
+            return NameKey(m_vAtoms[itr->second]);
+        }
+
+        if(m_umNameToIndex.size() >= m_sweepThreshold)
+        {
+            Sweep();
+        }
+
+        // 空いた番号があれば再利用する
+        std::uint32_t index;
+        if(!m_vFreeIndices.empty())
+        {
+            index = m_vFreeIndices.back();
+            m_vFreeIndices.pop_back();
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(m_vAtoms.size());
+            m_vAtoms.emplace_back();
+        }
+
+        // キーは保存した名前の文字列を指すので、先に名前を保存してから登録する
+        // 名前と参照カウントの領域は、まとめてテーブルのメモリリソースから確保する
+        std::pmr::memory_resource* pMemoryResource = m_vAtoms.get_allocator().resource();
+        SharedPtr<NameAtom> spAtom = AllocateShared<NameAtom>(std::pmr::polymorphic_allocator<NameAtom>(pMemoryResource),
+            a_name,std::hash<std::string_view>()(a_name),index,pMemoryResource);
+        m_umNameToIndex.emplace(spAtom->text,index);
+        m_vAtoms[index] = spAtom;
+        return NameKey(std::move(spAtom));
+    }
+
+    // 登録済みの名前のキーを返す (未登録なら何も指さないキーを返し、登録はしない)
+    NameKey Find(std::string_view a_name) const
+    {
+        auto itr = m_umNameToIndex.find(a_name);
+        if(itr == m_umNameToIndex.end())
+        {
+            return NameKey();
+        }
+        return NameKey(m_vAtoms[itr->second]);
+    }
+
+    // 登録済みの名前の番号を返す (未登録なら INVALID_INDEX)
+    // キーを作らないので参照カウントを操作せず、一度だけ引く検索に向く
+    std::uint32_t FindIndex(std::string_view a_name) const
+    {
+        auto itr = m_umNameToIndex.find(a_name);
+        if(itr == m_umNameToIndex.end())
+        {
+            return INVALID_INDEX;
+        }
+        return itr->second;
+    }
+
+    // キーがこのテーブルに登録された名前を指しているか (別のテーブルのキーや、Clear の前に取得したキーは false)
+    bool Contains(const NameKey& a_key) const
+    {
+        return !a_key.IsNull() && a_key.GetIndex() < m_vAtoms.size() && m_vAtoms[a_key.GetIndex()] == a_key.m_spAtom;
+    }
+
+    // 登録済みの名前の数
+    std::size_t GetCount() const
+    {
+        return m_umNameToIndex.size();
+    }
+
+    // 割り振った番号の上限 (番号を添え字にする配列はこの大きさで足りる)
+    std::size_t GetIndexCount() const
+    {
+        return m_vAtoms.size();
+    }
+
+    // 全ての名前を取り除く (取得済みのキーの文字列は、キーを持っている間は無効にならない)
+    // メモリリソースをまとめて解放できるよう、バケットの配列も含めて全て返す
+    void Clear()
+    {
+        std::pmr::memory_resource* pMemoryResource = m_vAtoms.get_allocator().resource();
+        NameToIndexMap(pMemoryResource).swap(m_umNameToIndex);
+        AtomList(pMemoryResource).swap(m_vAtoms);
+        IndexList(pMemoryResource).swap(m_vFreeIndices);
+        m_sweepThreshold = MIN_SWEEP_THRESHOLD;
+    }
+
+private:
+    // どのキーからも参照されていない名前を取り除き、番号を空ける
+    // キーをコピーできるのはメインスレッドでテーブルから取得するときだけなので、ここで参照がテーブルだけなら以降も参照されない
+    void Sweep()
+    {
+        for(std::uint32_t i = 0; i < m_vAtoms.size(); ++i)
+        {
+            SharedPtr<NameAtom>& spAtom = m_vAtoms[i];
+            if(spAtom != nullptr && spAtom.use_count() == 1)
+            {
+                m_umNameToIndex.erase(spAtom->text);
+                spAtom = nullptr;
+                m_vFreeIndices.push_back(i);
+            }
+        }
+        m_sweepThreshold = std::max(MIN_SWEEP_THRESHOLD,m_umNameToIndex.size() * 2);
+    }
+
+    // 整理を始める登録数の最小値 (少ない登録数で何度も整理しないようにする)
+    static constexpr std::size_t MIN_SWEEP_THRESHOLD = 64;
+
+    // 名前から番号を引くコンテナ (キーは m_vAtoms に保存した名前の文字列を指す)
+    using NameToIndexMap = std::pmr::unordered_map<std::string_view,std::uint32_t>;
+    NameToIndexMap m_umNameToIndex;
+
+    // 番号ごとの名前 (取り除いた番号は nullptr)
+    using AtomList = std::pmr::vector<SharedPtr<NameAtom>>;
+    AtomList m_vAtoms;
+
+    // 取り除かれて空いた番号
+    using IndexList = std::pmr::vector<std::uint32_t>;
+    IndexList m_vFreeIndices;
+
+    // 登録数がこの数に達したら整理する
+    std::size_t m_sweepThreshold = MIN_SWEEP_THRESHOLD;
+};
+
+#endif // NAME_TABLE_HPP
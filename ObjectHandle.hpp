@@ -0,0 +1,62 @@
+﻿#ifndef OBJECT_HANDLE_HPP
+#define OBJECT_HANDLE_HPP
+
+#include <cstdint>
+#include <functional>
+
+
+
+// ObjectManagerがオブジェクトごとに割り振る連番の番号
+// 削除されたオブジェクトの番号は再利用される
+using ObjectIndex = std::uint32_t;
+
+// 無効なオブジェクト番号を表す値
+constexpr ObjectIndex INVALID_OBJECT_INDEX = static_cast<ObjectIndex>(-1);
+
+
+// オブジェクトを参照するためのハンドル (番号 + 世代)
+// 番号が再利用されるたびに世代が進むため、削除済みのオブジェクトを指すハンドルは
+// ObjectManager::IsValid / Resolve で無効と判定される
+// shared_ptr/weak_ptr と違い参照カウントを持たないので、コピーや有効判定にアトミック操作が要らない
+struct ObjectHandle
+{
+    ObjectIndex index = INVALID_OBJECT_INDEX;
+    std::uint32_t generation = 0;
+
+    // 何も指していないか (有効かどうかは ObjectManager::IsValid で調べる)
+    bool IsNull() const
+    {
+        return index == INVALID_OBJECT_INDEX;
+    }
+
+    // 64bitの値にまとめる (保存やハッシュのキーに使う)
+    std::uint64_t ToUInt64() const
+    {
+        return (static_cast<std::uint64_t>(generation) << 32) | index;
+    }
+
+    bool operator==(const ObjectHandle& a_other) const
+    {
+        return index == a_other.index && generation == a_other.generation;
+    }
+
+    bool operator!=(const ObjectHandle& a_other) const
+    {
+        return !(*this == a_other);
+    }
+};
+
+// unordered_map などのキーに使えるようにする
+namespace std
+{
+    template<>
+    struct hash<ObjectHandle>
+    {
+        std::size_t operator()(const ObjectHandle& a_handle) const
+        {
+            return std::hash<std::uint64_t>()(a_handle.ToUInt64());
+        }
+    };
+}
+
+#endif // OBJECT_HANDLE_HPP
@@ -1,91 +1,566 @@
-﻿#include "Component.hpp"
+﻿#ifndef OBJECT_MANAGER_HPP
+#define OBJECT_MANAGER_HPP
+
+#include "Component.hpp"
+#include "ArchetypeStorage.hpp"
+#include "ComponentPool.hpp"
+#include "ThreadPool.hpp"
+#include "SystemScheduler.hpp"
+#include "SlotMap.hpp"
+#include "Prefab.hpp"
+#include "ObjectReclaimer.hpp"
+#include "FrameScratchResource.hpp"
+#include <queue>
+#include <charconv>
+#include <chrono>
+#include <memory_resource>
+
+
+// データコンポーネント(ComponentBaseを継承しない型)の格納方法
+enum class DataStorageType
+{
+	// 同じ型の組み合わせを持つオブジェクトをチャンクにまとめる
+	// 複数の型をまとめて辿る処理が速いが、型の追加/削除のたびに行の移動が起きる
+	Archetype,
+
+	// 型ごとのスパースセットに格納する
+	// 型の追加/削除/有無の確認が全てO(1)なので、頻繁に付け外しする場合に向く
+	SparseSet,
+};
 
 
 // 全てのGameObjectを管理するクラス
 class ObjectManager
 {
 public:
+	// a_pMemoryResource: オブジェクト・コンポーネント・名前の文字列と紐づけの確保に使うメモリリソース
+	// std::pmr::monotonic_buffer_resource などを渡すと、ステージ単位のメモリをまとめて確保/解放できる
+	// (ReleaseAllObjects を呼び、InternName で取得したキーも手放してからメモリリソースを解放すること)
+	// 同期を取らないメモリリソースを渡す場合は、SetBackgroundDestroy を有効にしないこと
+	explicit ObjectManager(DataStorageType a_dataStorageType = DataStorageType::Archetype,
+		std::pmr::memory_resource* a_pMemoryResource = std::pmr::get_default_resource())
+		: m_dataStorageType(a_dataStorageType)
+		, m_pMemoryResource(a_pMemoryResource)
+		, m_frameScratch(FRAME_SCRATCH_INITIAL_SIZE,a_pMemoryResource)
+		, m_nameTable(a_pMemoryResource)
+		, m_umNameCounters(a_pMemoryResource)
+		, m_vNameEntries(a_pMemoryResource)
+	{
+	}
 
-	// 引数の名前のオブジェクトを作成して返す関数
+	// ObjectManagerより長生きするオブジェクトがストレージを参照しないよう、関連を切っておく
+	~ObjectManager()
+	{
+		for (const auto& obj : m_slotMapObjects.GetDense())
+		{
+			if (obj)
+			{
+				obj->DetachStorage();
+			}
+		}
+	}
+
+	ObjectManager(const ObjectManager&) = delete;
+	ObjectManager& operator=(const ObjectManager&) = delete;
+
+	// 引数の名前のオブジェクトを作成し、そのハンドルを返す関数
 	// 同じ名前のオブジェクトが既に存在していた場合、名前の後ろに番号が付く
-	std::shared_ptr<GameObject> GenerateObject(std::string_view a_name)
+	// オブジェクトを保持するときは shared_ptr/weak_ptr ではなくハンドルを使うとよい
+	ObjectHandle CreateObject(std::string_view a_name)
 	{
-		// オブジェクトのインスタンスを作成
-		std::shared_ptr<GameObject> spNewObject = std::make_shared<GameObject>();
-		// 生成するオブジェクトの名前を求める
-		std::string objName = CreateObjName(a_name);
+		return GenerateObject(a_name)->GetHandle();
+	}
 
-		// オブジェクトに名前をセット
-		spNewObject->SetName(objName);
-		// オブジェクトを有効にする
-		spNewObject->SetActive(true);
+	// 名前を登録せずにオブジェクトを作成し、そのハンドルを返す関数
+	// パーティクルや弾など、名前から探すことの無いオブジェクト向け
+	// 名前の生成や文字列の確保、ハッシュ計算を一切行わない (GetName() は空になる)
+	// 後から名前で探したくなったら RegisterObjectName で名前を登録できる
+	ObjectHandle SpawnObject()
+	{
+		return InsertNewObject(AcquireObject())->GetHandle();
+	}
 
-		// オブジェクトをリストに追加し、そのイテレータを取得
-		m_lObjects.emplace_back(spNewObject);
-		auto objItr = std::prev(m_lObjects.end());
-		// オブジェクトの名前とイテレータを紐づける
-		m_umNameToObjPtr[objName] = objItr;
+	// プレハブからオブジェクトを引数の数だけ作成し、そのハンドルをまとめて返す
+	// オブジェクトとコンポーネントのメモリは、数回の大きな確保(BulkArena)から切り出す
+	// アリーナは作ったオブジェクトとコンポーネントが全て破棄されるまで解放されないため、
+	// 同じ時期に消える群れ(敵の波やパーティクルなど)に使うこと
+	// プレハブに名前があれば CreateObject と同じ規則で名前を登録する
+	std::vector<ObjectHandle> Instantiate(const Prefab& a_prefab,std::size_t a_count)
+	{
+		std::vector<ObjectHandle> vHandles;
+		if (a_count == 0)
+		{
+			return vHandles;
+		}
+		vHandles.reserve(a_count);
+		m_slotMapObjects.Reserve(m_slotMapObjects.GetCount() + a_count);
+		m_vPendingStart.reserve(m_vPendingStart.size() + a_count);
+
+		BulkArena* pArena = BulkArena::Create(a_prefab.GetBytesPerInstance() * a_count);
+		for (std::size_t i = 0; i < a_count; ++i)
+		{
+			SharedPtr<GameObject> spNewObject = InsertNewObject(AllocateShared<GameObject>(BulkAllocator<GameObject>(pArena),m_pMemoryResource));
+			ObjectHandle handle = spNewObject->GetHandle();
+			if (!a_prefab.GetName().empty())
+			{
+				AssignObjName(*spNewObject,a_prefab.GetName());
+			}
+			a_prefab.Apply(*spNewObject,pArena);
+			vHandles.push_back(handle);
+		}
+		// 以降はオブジェクトとコンポーネントが持つ参照だけでアリーナを生かす
+		pArena->Release();
+
+		return vHandles;
+	}
+
+	// 引数のオブジェクトに名前を登録し、GetObject/FindObject で探せるようにする
+	// 名前の決め方は CreateObject と同じで、既に名前が登録されていれば付け替える
+	// オブジェクトが既に削除されていれば false を返す
+	bool RegisterObjectName(ObjectHandle a_handle,std::string_view a_name)
+	{
+		GameObject* pObj = Resolve(a_handle);
+		if (pObj == nullptr)
+		{
+			return false;
+		}
+		if (pObj->m_isNameRegistered)
+		{
+			ReleaseObjName(pObj->GetNameKey());
+		}
+		AssignObjName(*pObj,a_name);
+		return true;
+	}
+
+	// ハンドルが指すオブジェクトがまだ存在しているか (O(1))
+	bool IsValid(ObjectHandle a_handle) const
+	{
+		return Resolve(a_handle) != nullptr;
+	}
+
+	// ハンドルが指すオブジェクトを取得する (O(1)、既に削除されていればnullptr)
+	// 参照カウントを操作しないため、返したポインタはオブジェクトが削除されるまでの間だけ使うこと
+	GameObject* Resolve(ObjectHandle a_handle) const
+	{
+		const SharedPtr<GameObject>* pspObj = m_slotMapObjects.Find(a_handle);
+		return pspObj != nullptr ? pspObj->get() : nullptr;
+	}
+
+	// 名前からオブジェクトのハンドルを取得する (見つからなければ何も指さないハンドル)
+	// 引数をそのままキーとして引くので、文字列の確保は行わない (終端文字が無くても良い)
+	// 同じ名前で何度も探すなら、InternName で取得したキーを渡す版を使うとよい
+	ObjectHandle FindObject(std::string_view a_name) const
+	{
+		// キーを作らずに番号だけ引く (参照カウントを操作しない)
+		std::uint32_t index = m_nameTable.FindIndex(a_name);
+		if (index >= m_vNameEntries.size())
+		{
+			return ObjectHandle();
+		}
+		return m_vNameEntries[index].handle;
+	}
+
+	// 名前のキーからオブジェクトのハンドルを取得する (ハッシュ計算も文字列の比較も行わず、配列を引くだけ)
+	// 例: NameKey playerKey = objectManager.InternName("Player"); として一度だけ取得しておき、毎フレームこれで探す
+	// 別の ObjectManager で取得したキーでは見つからない
+	ObjectHandle FindObject(const NameKey& a_nameKey) const
+	{
+		if (!m_nameTable.Contains(a_nameKey) || a_nameKey.GetIndex() >= m_vNameEntries.size())
+		{
+			return ObjectHandle();
+		}
+		return m_vNameEntries[a_nameKey.GetIndex()].handle;
+	}
+
+	// 名前を登録してキーを返す (FindObject/GetObject に渡すキーを前もって取得しておくのに使う)
+	// キーを持っている間は名前が登録されたままになるので、番号付きの名前などを大量に取得して持ち続けないこと
+	NameKey InternName(std::string_view a_name)
+	{
+		return m_nameTable.Intern(a_name);
+	}
+
+	// ハンドルからオブジェクトを取得する (互換用)
+	WeakPtr<GameObject> GetObject(ObjectHandle a_handle)
+	{
+		GameObject* pObj = Resolve(a_handle);
+		if (pObj == nullptr)
+		{
+			return WeakPtr<GameObject>();
+		}
+		return pObj->weak_from_this();
+	}
+
+	// 引数の名前のオブジェクトを作成して返す関数
+	// 同じ名前のオブジェクトが既に存在していた場合、名前の後ろに番号が付く
+	SharedPtr<GameObject> GenerateObject(std::string_view a_name)
+	{
+		SharedPtr<GameObject> spNewObject = InsertNewObject(AcquireObject());
+
+		// 被らない名前を求めてオブジェクトにセットする (名前とハンドルもここで紐づけられる)
+		AssignObjName(*spNewObject,a_name);
 
 		return spNewObject;
 	}
 
 	// 名前からオブジェクトを取得する
-	std::weak_ptr<GameObject> GetObject(std::string_view a_name)
+	WeakPtr<GameObject> GetObject(std::string_view a_name)
+	{
+		return GetObject(FindObject(a_name));
+	}
+
+	// 名前のキーからオブジェクトを取得する
+	WeakPtr<GameObject> GetObject(const NameKey& a_nameKey)
 	{
-		auto itr = m_umNameToObjPtr.find(a_name.data());
-		if (itr == m_umNameToObjPtr.end() || *itr->second == nullptr)
+		return GetObject(FindObject(a_nameKey));
+	}
+
+	// 引数の型のデータコンポーネントを全て持つオブジェクトのデータに対して関数を呼ぶ
+	// 例: ForEach<Position, Velocity>([](Position& p, Velocity& v) { ... });
+	template<typename...DataTypes,typename Func>
+	void ForEach(Func&& a_func)
+	{
+		if (m_dataStorageType == DataStorageType::Archetype)
+		{
+			m_archetypeStorage.ForEach<DataTypes...>(std::forward<Func>(a_func));
+		}
+		else
+		{
+			m_componentPools.ForEach<DataTypes...>(std::forward<Func>(a_func));
+		}
+	}
+
+	// 引数の型のコンポーネント(ComponentBaseを継承した型)全てに対して関数を呼ぶ
+	// 型ごとのプールに隙間なく並んだものを先頭から辿る (関数の中でコンポーネントを削除しても良い)
+	template<typename CompType,typename Func>
+	void ForEachComponent(Func&& a_func)
+	{
+		static_assert(std::is_base_of<ComponentBase,CompType>::value,"CompType must derive from ComponentBase");
+
+		auto* pPool = m_componentPools.FindPool<SharedPtr<CompType>>(ComponentTypeRegistry::GetID<CompType>());
+		if (pPool == nullptr)
 		{
-			return std::weak_ptr<GameObject>();
+			return;
 		}
-		return *itr->second;
+		pPool->Lock();
+		std::vector<SharedPtr<CompType>>& vDense = pPool->GetDense();
+		for (std::size_t i = 0; i < vDense.size(); ++i)
+		{
+			if (pPool->IsAlive(i))
+			{
+				a_func(*vDense[i]);
+			}
+		}
+		pPool->Unlock();
+	}
+
+	// オブジェクト・コンポーネント・名前の紐づけの確保に使うメモリリソース
+	std::pmr::memory_resource* GetMemoryResource() const
+	{
+		return m_pMemoryResource;
+	}
+
+	// データコンポーネントの格納方法
+	DataStorageType GetDataStorageType() const
+	{
+		return m_dataStorageType;
+	}
+
+	// 型ごとのプールを取得する
+	ComponentPools& GetComponentPools()
+	{
+		return m_componentPools;
+	}
+
+	// データコンポーネントを格納しているストレージを取得する
+	ArchetypeStorage& GetArchetypeStorage()
+	{
+		return m_archetypeStorage;
 	}
 
 	// 更新関数
 	void Update()
 	{
-		// 無効なオブジェクトを全て削除
+		// 無効なオブジェクトを全てワールドから取り除き、破棄待ちに積む
 		RemoveUnActuveObjects();
+
+		// 破棄待ちのオブジェクトを、1フレームの上限まで破棄する
+		DestroyQueuedObjects();
+	}
+
+	// 1回の Update で破棄するオブジェクトの上限をセットする (0 なら上限無し)
+	// 無効にされたオブジェクトはすぐにワールドから取り除かれ(ハンドルも無効になり)、更新も呼ばれなくなるが、
+	// デストラクタ(コンポーネントの OnRelease とメモリの解放)は上限の範囲で次のフレーム以降に分けて行う
+	// 大量のオブジェクトが同じフレームで消えても処理落ちしないようにするためのもの
+	// 時間の上限は目安で、毎フレーム少なくとも1つは破棄する
+	// SetBackgroundDestroy を有効にしていれば、上限の範囲で OnRelease を呼んで別のスレッドへ渡す
+	void SetDestroyBudget(std::size_t a_maxCount,std::chrono::microseconds a_maxTime = std::chrono::microseconds::zero())
+	{
+		m_destroyBudgetCount = a_maxCount;
+		m_destroyBudgetTime = a_maxTime;
+	}
+
+	// オブジェクトとコンポーネントの破棄(デストラクタとメモリの解放)を別のスレッドで行うか
+	// 有効にすると、Update の破棄の段階ではメインスレッドで OnRelease だけを呼び、インスタンスは別のスレッドへ渡す
+	// MAIN_THREAD_DESTROY を宣言した型のコンポーネントは、そのままメインスレッドで破棄する
+	// 無効に戻すと、別のスレッドへ渡したものを全て破棄し終えるまで待つ
+	void SetBackgroundDestroy(bool a_isEnabled)
+	{
+#if GAMEOBJECT_NONATOMIC_REFCOUNT
+		// 参照カウントを複数のスレッドから操作できないため、常にメインスレッドで破棄する
+		a_isEnabled = false;
+#endif
+		if (a_isEnabled && !m_upReclaimer)
+		{
+			m_upReclaimer = std::make_unique<ObjectReclaimer>();
+		}
+		else if (!a_isEnabled)
+		{
+			m_upReclaimer.reset();
+		}
 	}
 
+	// 破棄されたオブジェクトを再利用のために溜めておく数の上限をセットする (0 なら再利用しない)
+	// 溜めたオブジェクトは CreateObject/GenerateObject/SpawnObject で作り直さずに使われ、
+	// コンポーネントの配列の領域も確保したまま使い回す
+	// 他から shared_ptr で参照されているオブジェクトは溜めない。weak_ptr は再利用後のオブジェクトを指してしまうので、
+	// 再利用を有効にするならオブジェクトはハンドルで持つこと
+	void SetObjectRecycleCapacity(std::size_t a_capacity)
+	{
+		m_objectRecycleCapacity = a_capacity;
+		if (m_vRecycledObjects.size() > a_capacity)
+		{
+			m_vRecycledObjects.resize(a_capacity);
+		}
+		RefreshRecycleEnabled();
+	}
+
+	// 破棄された引数の型のコンポーネントを再利用のために溜めておく数の上限をセットする (0 なら再利用しない)
+	// 溜めたコンポーネントは OnRelease の後で OnReset が呼ばれ、同じ型の AddComponent で作り直さずに使われる
+	// オブジェクトの破棄だけでなく、RemoveComponent で外されたコンポーネントも溜める
+	template<typename CompType>
+	void SetComponentRecycleCapacity(std::size_t a_capacity)
+	{
+		static_assert(std::is_base_of<ComponentBase,CompType>::value,"CompType must derive from ComponentBase");
+		m_componentRecycler.SetCapacity<CompType>(a_capacity);
+		RefreshRecycleEnabled();
+	}
+
+	// 破棄を待っているオブジェクトの数
+	std::size_t GetDestroyQueueCount() const
+	{
+		return m_vDestroyQueue.size() - m_destroyQueueHead;
+	}
+
+	// 破棄を待っているオブジェクトを上限に関係なく全て破棄する (シーンの切り替え時など)
+	void FlushDestroyQueue()
+	{
+		while (GetDestroyQueueCount() != 0)
+		{
+			// 破棄の途中でキューが操作されても良いよう、取り出してから破棄する
+			DestroyObject(PopDestroyQueue());
+		}
+		SubmitReclaim();
+	}
 
+	// UpdateWorld で使うスレッドの数をセットする (メインスレッドを含む)
+	// 1 なら全てメインスレッドで処理し、0 ならCPUのコア数に合わせる
+	// 複数のスレッドで呼ばれるのは THREAD_SAFE を宣言した型のコンポーネントだけで、それ以外はメインスレッドで呼ぶ
+	// 処理(OnPreUpdate/OnUpdate/OnPostUpdate)の間では全てのスレッドの処理が終わるのを待つ
+	void SetUpdateThreadCount(std::size_t a_threadCount)
+	{
+		if (a_threadCount == 0)
+		{
+			a_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(),1);
+		}
+#if GAMEOBJECT_NONATOMIC_REFCOUNT
+		// 参照カウントを複数のスレッドから操作できないため、常にメインスレッドだけで処理する
+		a_threadCount = 1;
+#endif
+		m_upThreadPool.reset();
+		if (a_threadCount > 1)
+		{
+			m_upThreadPool = std::make_unique<ThreadPool>(a_threadCount - 1);
+		}
+	}
 
+	// UpdateWorld で使うスレッドの数 (メインスレッドを含む)
+	std::size_t GetUpdateThreadCount() const
+	{
+		return m_upThreadPool ? m_upThreadPool->GetThreadCount() : 1;
+	}
 
-	// 引数の名前を元に被らない名前を作成する
-	std::string CreateObjName(std::string_view a_baseName)
+	// 読む型と書く型を宣言した処理(システム)を登録する
+	// UpdateWorld の中で、引数の処理(OnPreUpdate/OnUpdate/OnPostUpdate)を全てのコンポーネントに呼んだ後に実行される
+	// アクセスする型が衝突しないシステム同士は、SetUpdateThreadCount でスレッドを増やしていれば同時に実行される
+	// 例: AddSystem<SystemReads<TransformComponent>,SystemWrites<>>("Render",[](ObjectManager& a_world) { ... });
+	// コンポーネントやオブジェクトを追加/削除するシステムは SystemWrites に SystemStructuralChange を含めること (他のシステムと同時に実行されなくなる)
+	template<typename ReadList,typename WriteList,typename Func>
+	void AddSystem(std::string_view a_name,Func&& a_func,ComponentHookList a_phase = HOOK_LIST_UPDATE)
 	{
-		std::string resultName;
+		m_systemScheduler.AddSystem<ReadList,WriteList>(a_name,a_phase,std::forward<Func>(a_func));
+	}
 
-		// 引数の名前のオブジェクトが既に存在しているか調べる
-		auto itr = m_umNameToObjPtr.find(a_baseName.data());
-		bool isFirstName = false;
+	// 引数の名前のシステムを取り除く
+	void RemoveSystem(std::string_view a_name)
+	{
+		m_systemScheduler.RemoveSystem(a_name);
+	}
 
-		// 初めての名前ならその名前のまま登録
-		if (itr == m_umNameToObjPtr.end())
+	// 全てのオブジェクトを1フレーム分更新する
+	// 経過時間は前回の UpdateWorld() からの実時間 (最初のフレームは1/60秒) になる
+	void UpdateWorld()
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		float deltaTime = FrameContext().deltaTime;
+		if (m_lastUpdateTime != std::chrono::steady_clock::time_point())
 		{
-			isFirstName = true;
+			deltaTime = std::chrono::duration<float>(now - m_lastUpdateTime).count();
 		}
+		m_lastUpdateTime = now;
+		UpdateWorld(deltaTime);
+	}
 
-		// 既に存在する名前なら、名前が重複しないように番号を付ける
-		for (size_t i = 1; true; ++i)
+	// 全てのオブジェクトを、引数の経過時間(秒)で1フレーム分更新する (固定の時間で進めるときに使う)
+	// 各コンポーネントの処理には、経過時間・フレーム番号・このワールド・一時メモリを UpdateContext として渡す
+	// 1. 無効なオブジェクトを全て取り除き、破棄待ちのオブジェクトを上限まで破棄する
+	// 2. まだ更新されていないオブジェクトの OnStart
+	// 3. 全てのコンポーネントの OnPreUpdate (その後、この処理に登録されたシステム)
+	// 4. 全てのコンポーネントの OnUpdate (同上)
+	// 5. 全てのコンポーネントの OnPostUpdate (同上)
+	// の順に、処理ごとに回す。3～5 はオブジェクトごとではなくコンポーネントの型ごとに、
+	// 型ごとのプールを先頭から辿って呼ぶ (呼び先が毎回同じになり、コードやデータがキャッシュに残りやすい)
+	// そのため同じ処理の中では、オブジェクトの順ではなく型の順に呼ばれる
+	// 処理の途中で生成されたオブジェクトは、次のフレームの OnStart から更新される
+	void UpdateWorld(float a_deltaTime)
+	{
+		// 前のフレームの一時メモリをまとめて解放する
+		m_frameScratch.Reset();
+		m_frameContext.deltaTime = a_deltaTime;
+		m_frameContext.pWorld = this;
+		m_frameContext.pScratch = &m_frameScratch;
+
+		Update();
+
+		// OnStart はオブジェクトごとに、生成された順に呼ぶ
+		// OnStart の中で生成されたオブジェクトも配列の後ろに追加されるため、添え字でループする
+		// 開始後にコンポーネントを追加/削除したオブジェクトも、依存を確かめ直すためにここへ積まれる
+		std::size_t keepCount = 0;
+		for (std::size_t i = 0; i < m_vPendingStart.size(); ++i)
 		{
-			// 有効な名前を見つけたら終了
-			if (isFirstName)
+			ObjectHandle handle = m_vPendingStart[i];
+			GameObject* pObj = Resolve(handle);
+			if (pObj == nullptr)
 			{
-				break;
+				continue;
+			}
+			pObj->Start(m_frameContext);
+			// 無効にされているオブジェクトは、有効に戻るまで待つ
+			if (!pObj->IsStarted())
+			{
+				m_vPendingStart[keepCount++] = handle;
+			}
+		}
+		m_vPendingStart.resize(keepCount);
+
+		DispatchHook(HOOK_LIST_PRE_UPDATE);
+		m_systemScheduler.Run(HOOK_LIST_PRE_UPDATE,*this,m_upThreadPool.get());
+		DispatchHook(HOOK_LIST_UPDATE);
+		m_systemScheduler.Run(HOOK_LIST_UPDATE,*this,m_upThreadPool.get());
+		DispatchHook(HOOK_LIST_POST_UPDATE);
+		m_systemScheduler.Run(HOOK_LIST_POST_UPDATE,*this,m_upThreadPool.get());
+
+		++m_frameContext.frameIndex;
+	}
+
+	// 更新中のフレームの情報 (システムから経過時間や一時メモリを使うときに参照する)
+	const FrameContext& GetFrameContext() const
+	{
+		return m_frameContext;
+	}
+
+
+
+
+	// 引数の名前を元に被らない名前を作成して引数のオブジェクトにセットし、オブジェクトのハンドルと紐づける
+	// 初めての名前ならその名前のまま、既にあれば後ろに番号を付ける (Bullet, Bullet1, Bullet2, ...)
+	// 名前ごとに次の番号と、削除されて空いた番号(小さい順)を覚えておくので、空きを探して回ることは無い
+	// 名前の文字列は m_nameTable が1つだけ保持し、オブジェクトと紐づけにはそのキーを持たせる
+	void AssignObjName(GameObject& a_obj,std::string_view a_baseName)
+	{
+		NameKey baseKey = m_nameTable.Intern(a_baseName);
+		NameSuffixCounter& counter = m_umNameCounters[baseKey];
+		counter.baseKey = baseKey;
+
+		NameKey nameKey;
+		while (true)
+		{
+			// 空いた番号があれば小さいものから再利用する
+			std::uint32_t suffix;
+			if (!counter.pqFreeSuffixes.empty())
+			{
+				suffix = counter.pqFreeSuffixes.top();
+				counter.pqFreeSuffixes.pop();
+			}
+			else
+			{
+				suffix = counter.nextSuffix++;
 			}
 
-			// 新しい名前を作成
-			resultName = a_baseName.data() + std::to_string(i);
+			// 番号0は番号を付けない名前そのもの
+			// 番号付きの名前は作業用の文字列に作ってから登録する (登録済みなら確保は行わない)
+			nameKey = baseKey;
+			if (suffix > 0)
+			{
+				char digits[10];
+				char* pEnd = std::to_chars(digits,digits + sizeof(digits),suffix).ptr;
+				m_nameBuffer.assign(a_baseName);
+				m_nameBuffer.append(digits,pEnd);
+				nameKey = m_nameTable.Intern(m_nameBuffer);
+			}
 
-			itr = m_umNameToObjPtr.find(resultName);
-			// 新しい名前のオブジェクトが存在しなければ
-			if (itr == m_umNameToObjPtr.end())
+			// 番号は使われなくなった名前から再利用されるので、配列は同時に使われている名前の数までしか伸びない
+			if (nameKey.GetIndex() >= m_vNameEntries.size())
 			{
-				isFirstName = true;
+				m_vNameEntries.resize(m_nameTable.GetIndexCount());
 			}
+			NameEntry& entry = m_vNameEntries[nameKey.GetIndex()];
+			if (entry.handle.IsNull())
+			{
+				entry = NameEntry{ a_obj.GetHandle(),&counter,suffix };
+				++counter.liveCount;
+				break;
+			}
+			// 別の名前の番号付きと同じ名前を直接指定されていた場合 (例: "Bullet1")、その番号は飛ばして捨てる
+			// 空いた番号に戻すと次の作成でまた同じ番号を調べることになるので戻さない (数え方が取り除かれたら0から数え直す)
 		}
+		a_obj.SetNameKey(std::move(nameKey));
+		a_obj.m_isNameRegistered = true;
+	}
 
-		return resultName;
+	// 名前とハンドルの紐づけを解除し、その名前の番号を再利用できるようにする
+	void ReleaseObjName(const NameKey& a_nameKey)
+	{
+		if (!m_nameTable.Contains(a_nameKey) || a_nameKey.GetIndex() >= m_vNameEntries.size())
+		{
+			return;
+		}
+		NameEntry& entry = m_vNameEntries[a_nameKey.GetIndex()];
+		if (entry.handle.IsNull())
+		{
+			return;
+		}
+
+		NameSuffixCounter* pCounter = entry.pCounter;
+		pCounter->pqFreeSuffixes.push(entry.suffix);
+		--pCounter->liveCount;
+		entry = NameEntry();
+
+		// 使われている番号が無くなったら数え方ごと取り除く (次にその名前が使われたら0から数え直す)
+		// 空いた番号や使われなくなった元の名前を溜め込まないようにする
+		if (pCounter->liveCount == 0)
+		{
+			m_umNameCounters.erase(NameKey(pCounter->baseKey));
+		}
 	}
 
 
@@ -98,29 +573,67 @@ public:
 
 
 	// 無効なオブジェクトを全て削除する
+	// SetActive(false) で積まれた削除待ちのオブジェクトだけを調べるので、無効にされた数に比例する時間で済む
 	void RemoveUnActuveObjects()
 	{
-		for (auto itr = m_lObjects.begin(); itr != m_lObjects.end();)
+		// 削除中(OnRelease など)に無効にされたオブジェクトも配列の後ろに積まれるため、添え字でループする
+		for (std::size_t i = 0; i < m_vPendingRemove.size(); ++i)
 		{
-			// 無効なオブジェクトを削除する
-			if (itr->get() == nullptr || !itr->get()->IsActive())
+			GameObject* pObj = Resolve(m_vPendingRemove[i]);
+			if (pObj == nullptr)
 			{
-				// オブジェクトのポインタが生きていたら
-				if (itr->get() != nullptr)
-				{
-					// 名前とイテレータの情報を削除
-					m_umNameToObjPtr.erase(itr->get()->GetName().data());
-				}
+				continue;
+			}
+			pObj->m_isPendingRemove = false;
 
-				// オブジェクトのインスタンスを削除
-				itr = m_lObjects.erase(itr);
+			// 積まれた後で有効に戻されていれば削除しない
+			if (pObj->IsActive())
+			{
+				continue;
 			}
-			// 有効なオブジェクトなら何もせず次のオブジェクトを調べる
-			else
+
+			// 名前とハンドルの情報を削除 (名前を登録していないオブジェクトは何もしない)
+			if (pObj->m_isNameRegistered)
+			{
+				ReleaseObjName(pObj->GetNameKey());
+			}
+			// ストレージに格納された値はワールドから取り除き、オブジェクトのインスタンスは破棄待ちに積む
+			m_vDestroyQueue.push_back(DetachObject(*pObj));
+		}
+		m_vPendingRemove.clear();
+	}
+
+	// 破棄待ちのオブジェクトを、古いものから上限まで破棄する
+	void DestroyQueuedObjects()
+	{
+		if (GetDestroyQueueCount() == 0)
+		{
+			return;
+		}
+
+		bool hasTimeLimit = m_destroyBudgetTime.count() > 0;
+		std::chrono::steady_clock::time_point limitTime;
+		if (hasTimeLimit)
+		{
+			limitTime = std::chrono::steady_clock::now() + m_destroyBudgetTime;
+		}
+
+		std::size_t destroyedCount = 0;
+		while (GetDestroyQueueCount() != 0)
+		{
+			DestroyObject(PopDestroyQueue());
+			++destroyedCount;
+
+			if (m_destroyBudgetCount != 0 && destroyedCount >= m_destroyBudgetCount)
 			{
-				itr++;
+				break;
+			}
+			if (hasTimeLimit && std::chrono::steady_clock::now() >= limitTime)
+			{
+				break;
 			}
 		}
+		SubmitReclaim();
 	}
 
 
@@ -128,39 +641,263 @@ public:
 	// 全てのオブジェクトを強制的に解放 (ゲーム終了時など)
 	void ReleaseAllObjects() {
 		std::cout << "[ObjectManager] Releasing all objects..." << std::endl;
-		for(const auto& obj : m_lObjects) {
-			if(obj) {
-				// GameObject 内部のコンポーネントの OnRelease を呼ぶような仕組みがあっても良い
-				// ここでは ObjectManager が直接 GameObject を解放する
-				std::cout << "[ObjectManager] Releasing components for: " << obj->GetName() << std::endl;
-				// GameObject のデストラクタでコンポーネントの shared_ptr が解放されることを期待
-			}
+		for(const auto& obj : m_slotMapObjects.GetDense()) {
+			// GameObject 内部のコンポーネントの OnRelease を呼ぶような仕組みがあっても良い
+			// ここでは ObjectManager が直接 GameObject を解放する
+			std::cout << "[ObjectManager] Releasing components for: " << obj->GetName() << std::endl;
+			obj->DetachStorage();
 		}
-		m_lObjects.clear();
-		m_umNameToObjPtr.clear();
+		// GameObject のデストラクタでコンポーネントの shared_ptr が解放されることを期待
+		m_slotMapObjects.Clear();
+		FlushDestroyQueue();
+		m_vPendingRemove.clear();
+		m_vRecycledObjects.clear();
+		m_componentRecycler.Clear();
+		// メモリリソースをまとめて解放できるよう、バケットの配列も含めて全て返す
+		// (名前の文字列はオブジェクトが持つキーが参照しているので、ここで解放してもオブジェクトの名前は無効にならない)
+		NameEntryList(m_pMemoryResource).swap(m_vNameEntries);
+		NameCounterMap(m_pMemoryResource).swap(m_umNameCounters);
+		m_nameTable.Clear();
 		std::cout << "[ObjectManager] All objects released." << std::endl;
 	}
 private:
-	void RemoveInactiveObjects() {
-		// m_umNameToObjPtr から先に削除
-		for(auto it = m_lObjects.begin(); it != m_lObjects.end(); /* no increment */) {
-			if(*it && !(*it)->IsActive()) {
-				std::cout << "[ObjectManager] Removing inactive object: " << (*it)->GetName() << std::endl;
-				m_umNameToObjPtr.erase((*it)->GetName());
-				// OnRelease を呼びたい場合はここで呼ぶか、GameObject のデストラクタでコンポーネントが解放される際に呼ばれるようにする
-				// (*it)->CallAllComponentsOnRelease(); // 例えばこんなメソッドをGameObjectに用意する
-				it = m_lObjects.erase(it); // erase は次の有効なイテレータを返す
+	// 作成したオブジェクトのインスタンスを格納し、ストレージを使えるようにする (名前は登録しない)
+	SharedPtr<GameObject> InsertNewObject(SharedPtr<GameObject> spNewObject)
+	{
+		// 他のシステムと同時に実行している間は作成できない (SystemStructuralChange を宣言すること)
+		assert(!StructuralChangeLock::IsLocked() && "CreateObject in a system without SystemStructuralChange");
+
+		// オブジェクトを有効にする
+		spNewObject->SetActive(true);
+		// オブジェクトを格納して番号を割り振り、型ごとのプールを使えるようにする
+		ObjectHandle handle = m_slotMapObjects.Insert(spNewObject);
+		spNewObject->m_index = handle.index;
+		spNewObject->m_generation = handle.generation;
+		spNewObject->m_pComponentPools = &m_componentPools;
+		spNewObject->m_pvPendingRemove = &m_vPendingRemove;
+		spNewObject->m_pvPendingStart = &m_vPendingStart;
+		spNewObject->m_pComponentRecycler = &m_componentRecycler;
+		// データコンポーネントの格納先を決める (SparseSetなら型ごとのプールに格納する)
+		if (m_dataStorageType == DataStorageType::Archetype)
+		{
+			spNewObject->m_pArchetypeStorage = &m_archetypeStorage;
+		}
+
+		// 次の UpdateWorld で OnStart を呼ぶ
+		m_vPendingStart.push_back(handle);
+
+		return spNewObject;
+	}
+
+
+	// 引数の処理を実装している型のプールを順に辿り、型ごとにまとめて呼ぶ
+	// 処理の中で新しい型のプールが作られても良いよう、添え字でループする
+	void DispatchHook(ComponentHookList a_list)
+	{
+		const std::vector<ComponentHookDispatcher>& vDispatchers = m_componentPools.GetHookDispatchers();
+		for (std::size_t i = 0; i < vDispatchers.size(); ++i)
+		{
+			if ((vDispatchers[i].hookMask & HOOK_LIST_MASKS[a_list]) != 0)
+			{
+				// 複数のスレッドから呼んで良い型だけ、スレッドプールで分けて呼ぶ
+				ThreadPool* pThreadPool = vDispatchers[i].isThreadSafe ? m_upThreadPool.get() : nullptr;
+				vDispatchers[i].pfnDispatch(*vDispatchers[i].pPool,a_list,m_frameContext,pThreadPool);
+			}
+		}
+	}
+
+	// 破棄待ちの先頭のオブジェクトを取り出す
+	// 全て取り出したら配列を空に戻し、上限のため残り続けるときは取り出し済みの分が半分を超えたら詰める
+	SharedPtr<GameObject> PopDestroyQueue()
+	{
+		SharedPtr<GameObject> spObj = std::move(m_vDestroyQueue[m_destroyQueueHead]);
+		++m_destroyQueueHead;
+		if (m_destroyQueueHead == m_vDestroyQueue.size())
+		{
+			m_vDestroyQueue.clear();
+			m_destroyQueueHead = 0;
+		}
+		else if (m_destroyQueueHead * 2 > m_vDestroyQueue.size())
+		{
+			m_vDestroyQueue.erase(m_vDestroyQueue.begin(),m_vDestroyQueue.begin() + static_cast<std::ptrdiff_t>(m_destroyQueueHead));
+			m_destroyQueueHead = 0;
+		}
+		return spObj;
+	}
+
+	// 取り除いたオブジェクトを破棄する
+	// 再利用するなら OnRelease を呼んでからコンポーネントとオブジェクトを溜める
+	// 別のスレッドで破棄するなら、ここでは OnRelease だけを呼んで破棄する側へ渡す配列に積む
+	void DestroyObject(SharedPtr<GameObject> a_spObj)
+	{
+		if (!m_upReclaimer && !m_isRecycleEnabled)
+		{
+			return; // 引数が破棄される
+		}
+		a_spObj->ReleaseComponents(m_vMainThreadComps);
+		m_vMainThreadComps.clear();
+		if (m_isRecycleEnabled)
+		{
+			a_spObj->RecycleComponents(m_componentRecycler);
+			if (m_vRecycledObjects.size() < m_objectRecycleCapacity && a_spObj.use_count() == 1)
+			{
+				a_spObj->ResetForReuse();
+				m_vRecycledObjects.push_back(std::move(a_spObj));
+				return;
 			}
-			else {
-				++it;
+		}
+		if (m_upReclaimer)
+		{
+			m_vReclaimBatch.push_back(std::move(a_spObj));
+		}
+	}
+
+	// オブジェクトかコンポーネントのどちらかの上限が1以上のときだけ、破棄するときに再利用の処理を行う
+	void RefreshRecycleEnabled()
+	{
+		m_isRecycleEnabled = m_objectRecycleCapacity != 0 || m_componentRecycler.HasCapacity();
+	}
+
+	// 新しく格納するオブジェクトを用意する (再利用を待っているものがあればそれを使う)
+	SharedPtr<GameObject> AcquireObject()
+	{
+		if (m_vRecycledObjects.empty())
+		{
+			if (m_pMemoryResource != std::pmr::new_delete_resource())
+			{
+				return AllocateShared<GameObject>(std::pmr::polymorphic_allocator<GameObject>(m_pMemoryResource),m_pMemoryResource);
 			}
+			return MakeShared<GameObject>(m_pMemoryResource);
+		}
+		SharedPtr<GameObject> spObj = std::move(m_vRecycledObjects.back());
+		m_vRecycledObjects.pop_back();
+		return spObj;
+	}
+
+	// 積んだオブジェクトをまとめて破棄する側へ渡す
+	void SubmitReclaim()
+	{
+		if (m_upReclaimer)
+		{
+			m_upReclaimer->Push(m_vReclaimBatch);
 		}
 	}
 
-	// オブジェクトの名前とイテレータを紐づけるコンテナ
-	std::unordered_map<std::string, std::list<std::shared_ptr<GameObject>>::iterator> m_umNameToObjPtr;
+	// オブジェクトをストレージから取り除き、コンテナから削除する
+	// 世代が進むので、このオブジェクトを指していたハンドルは全て無効になる
+	// 破棄する時期を呼び出し元が決められるよう、オブジェクトのインスタンスは返す
+	SharedPtr<GameObject> DetachObject(GameObject& a_obj)
+	{
+		ObjectHandle handle = a_obj.GetHandle();
+		SharedPtr<GameObject> spObj = *m_slotMapObjects.Find(handle);
+		a_obj.DetachStorage();
+		m_slotMapObjects.Erase(handle);
+		return spObj;
+	}
+
+	// データコンポーネントの格納方法
+	DataStorageType m_dataStorageType;
+
+	// オブジェクト・コンポーネント・名前の紐づけの確保に使うメモリリソース
+	std::pmr::memory_resource* m_pMemoryResource;
+
+	// データコンポーネントをアーキタイプごとに格納するストレージ
+	// オブジェクトより先に破棄されないよう、オブジェクトのコンテナより前に宣言する
+	ArchetypeStorage m_archetypeStorage;
+
+	// 型ごとのプール (同じくオブジェクトのコンテナより前に宣言する)
+	ComponentPools m_componentPools;
+
+	// 生成されてからまだ OnStart が呼ばれていないオブジェクト
+	std::vector<ObjectHandle> m_vPendingStart;
+
+	// SetActive(false) で無効にされ、次の Update で削除するオブジェクト
+	std::vector<ObjectHandle> m_vPendingRemove;
+
+	// 更新処理を複数のスレッドで行うときのスレッドプール (SetUpdateThreadCount で作られる)
+	std::unique_ptr<ThreadPool> m_upThreadPool;
+
+	// 登録されたシステム
+	SystemScheduler m_systemScheduler;
+
+	// 更新中のフレームの情報 (UpdateWorld の始めにセットする)
+	FrameContext m_frameContext;
+
+	// 前回 UpdateWorld() を呼んだ時刻 (経過時間を測るのに使う)
+	std::chrono::steady_clock::time_point m_lastUpdateTime;
+
+	// フレームの間だけ使う一時メモリ (UpdateWorld の始めにまとめて解放する)
+	static constexpr std::size_t FRAME_SCRATCH_INITIAL_SIZE = 64 * 1024;
+	FrameScratchResource m_frameScratch;
+
+	// 同じ名前を元にしたオブジェクトの名前に付ける番号
+	struct NameSuffixCounter
+	{
+		// まだ使われたことの無い最小の番号 (0は番号を付けない名前そのもの)
+		std::uint32_t nextSuffix = 0;
+
+		// 削除されて空いた番号 (小さい順に取り出す)
+		std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, std::greater<std::uint32_t>> pqFreeSuffixes;
+
+		// この元の名前から作られ、今も使われている名前の数
+		std::uint32_t liveCount = 0;
+
+		// 元の名前 (全ての番号が空いたときに、これをキーにして取り除く)
+		NameKey baseKey;
+	};
+
+	// 名前に紐づくオブジェクトと、その名前を作った元の名前の番号
+	struct NameEntry
+	{
+		ObjectHandle handle; // 紐づいていなければ何も指さない
+		NameSuffixCounter* pCounter = nullptr; // 要素のアドレスは変わらないので、ポインタで持つ
+		std::uint32_t suffix = 0;
+	};
+
+	// オブジェクトの名前を1つずつだけ保持するテーブル (番号を m_vNameEntries の添え字にする)
+	NameTable m_nameTable;
+
+	// 元の名前ごとの番号の数え方 (キーのハッシュ値は登録時に求めたものを使う)
+	using NameCounterMap = std::pmr::unordered_map<NameKey, NameSuffixCounter, NameKey::Hash>;
+	NameCounterMap m_umNameCounters;
+
+	// 名前とオブジェクトのハンドルの紐づけ (m_nameTable で割り振った NameKey::GetIndex() を添え字にする)
+	using NameEntryList = std::pmr::vector<NameEntry>;
+	NameEntryList m_vNameEntries;
+
+	// 番号付きの名前を作る作業用の文字列 (確保し直さないようメンバに持つ)
+	std::string m_nameBuffer;
+
+	// ワールドから取り除かれ、破棄を待っているオブジェクト (m_destroyQueueHead 番目から古い順)
+	// 生成と破棄を繰り返しても確保し直さないよう、配列の領域を使い回す
+	std::vector<SharedPtr<GameObject>> m_vDestroyQueue;
+	std::size_t m_destroyQueueHead = 0;
+
+	// 1回の Update で破棄するオブジェクトの数と時間の上限 (0 なら上限無し)
+	std::size_t m_destroyBudgetCount = 0;
+	std::chrono::microseconds m_destroyBudgetTime = std::chrono::microseconds::zero();
+
+	// オブジェクトの破棄を行う別のスレッド (SetBackgroundDestroy で作られる)
+	std::unique_ptr<ObjectReclaimer> m_upReclaimer;
+
+	// 破棄する側へ渡すオブジェクトと、メインスレッドで破棄するコンポーネント (確保し直さないようメンバに持つ)
+	std::vector<SharedPtr<void>> m_vReclaimBatch;
+	std::vector<SharedPtr<ComponentBase>> m_vMainThreadComps;
+
+	// 再利用を待っているオブジェクトと、溜めておく数の上限
+	std::vector<SharedPtr<GameObject>> m_vRecycledObjects;
+	std::size_t m_objectRecycleCapacity = 0;
+
+	// 再利用を待っているコンポーネント (型ごとに上限をセットしたものだけ)
+	ComponentRecycler m_componentRecycler;
+
+	// オブジェクトかコンポーネントの再利用の上限がセットされたか
+	bool m_isRecycleEnabled = false;
 
 	// 全てのオブジェクトのインスタンスを格納するコンテナ
-	std::list<std::shared_ptr<GameObject>> m_lObjects;
+	// 隙間なく並べて持ち、ハンドルの番号から O(1) で引ける (番号はプールの添え字にもなる)
+	SlotMap<SharedPtr<GameObject>> m_slotMapObjects;
+
+};
 
-};
\ No newline at end of file
+#endif // OBJECT_MANAGER_HPP
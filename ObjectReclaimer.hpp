@@ -0,0 +1,100 @@
+﻿#ifndef OBJECT_RECLAIMER_HPP
+#define OBJECT_RECLAIMER_HPP
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+#include "RefCountPolicy.hpp"
+
+
+
+// 渡されたインスタンスの破棄(デストラクタとメモリの解放)を別のスレッドで行うクラス
+// メインスレッドは参照を渡すだけで済むので、大量のオブジェクトが消えても破棄の時間がフレームに乗らない
+// 渡すインスタンスのデストラクタは、メインスレッドの処理と同時に動いても問題無いものに限る
+class ObjectReclaimer
+{
+public:
+    ObjectReclaimer()
+        : m_thread([this]() { ThreadMain(); })
+    {
+    }
+
+    // 渡されたインスタンスを全て破棄し終えてからスレッドを止める
+    ~ObjectReclaimer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_cvWake.notify_one();
+        m_thread.join();
+    }
+
+    ObjectReclaimer(const ObjectReclaimer&) = delete;
+    ObjectReclaimer& operator=(const ObjectReclaimer&) = delete;
+
+    // 引数のインスタンスをまとめて破棄する側へ渡す (引数の配列は空になる)
+    // ロックを取る回数を減らすため、1フレーム分をまとめて渡すこと
+    void Push(std::vector<SharedPtr<void>>& a_vInstances)
+    {
+        if(a_vInstances.empty())
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_vPending.empty())
+            {
+                m_vPending.swap(a_vInstances);
+            }
+            else
+            {
+                for(SharedPtr<void>& spInstance : a_vInstances)
+                {
+                    m_vPending.push_back(std::move(spInstance));
+                }
+                a_vInstances.clear();
+            }
+        }
+        m_cvWake.notify_one();
+    }
+
+private:
+    void ThreadMain()
+    {
+        // 破棄する側の配列 (確保し直さないよう、渡された配列と入れ替えて使い回す)
+        std::vector<SharedPtr<void>> vReclaim;
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cvWake.wait(lock,[this]() { return m_isStopping || !m_vPending.empty(); });
+                if(m_vPending.empty())
+                {
+                    return; // 止める指示があり、破棄するものも残っていない
+                }
+                vReclaim.swap(m_vPending);
+            }
+
+            // ロックを取らずに破棄する
+            vReclaim.clear();
+        }
+    }
+
+private:
+    // メインスレッドから渡され、まだ破棄していないインスタンス
+    std::vector<SharedPtr<void>> m_vPending;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cvWake;
+    bool m_isStopping = false;
+
+    // 破棄を行うスレッド (他のメンバの後に初期化されるよう最後に宣言する)
+    std::thread m_thread;
+};
+
+#endif // OBJECT_RECLAIMER_HPP
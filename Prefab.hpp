@@ -0,0 +1,105 @@
+﻿#ifndef PREFAB_HPP
+#define PREFAB_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <functional>
+#include <type_traits>
+
+#include "Component.hpp"
+#include "BulkAllocator.hpp"
+
+
+
+// 同じ構成のオブジェクトをまとめて作るための設計図
+// 追加するコンポーネントの型とコンストラクタの引数を記録しておき、ObjectManager::Instantiate で複製する
+// 例: Prefab enemy("Enemy");
+//     enemy.AddComponent<TransformComponent>(50.0f, 100.0f).AddComponent<RendererComponent>();
+//     std::vector<ObjectHandle> vHandles = objectManager.Instantiate(enemy, 100);
+class Prefab
+{
+public:
+    // 名前を空にすると、作られるオブジェクトは名前を登録しない (SpawnObject と同じ)
+    explicit Prefab(std::string_view a_name = std::string_view())
+        : m_name(a_name)
+    {
+    }
+
+    // 追加するコンポーネントを記録する
+    // 引数はここでコピーして保存し、作るたびにコンストラクタへ渡す (コピーできる引数であること)
+    // ComponentBase を継承しない型はデータコンポーネントとして追加される
+    template<typename CompType,typename...ArgTypes>
+    Prefab& AddComponent(ArgTypes&&... a_args)
+    {
+        Recipe recipe;
+        auto args = std::make_tuple(std::decay_t<ArgTypes>(std::forward<ArgTypes>(a_args))...);
+        if constexpr(std::is_base_of<ComponentBase,CompType>::value)
+        {
+            // shared_ptr の制御ブロックとコンポーネントを1回で置く大きさ
+            recipe.allocSize = sizeof(CompType) + alignof(CompType) + SHARED_CONTROL_BLOCK_SIZE;
+            recipe.fnAttach = [args](GameObject& a_obj,BulkArena* a_pArena)
+                {
+                    a_obj.AttachComponent(std::apply([a_pArena](const auto&... a_ctorArgs)
+                        {
+                            return AllocateShared<CompType>(BulkAllocator<CompType>(a_pArena),a_ctorArgs...);
+                        },args));
+                };
+        }
+        else
+        {
+            // データコンポーネントは ObjectManager のストレージに格納されるので、アリーナは使わない
+            recipe.allocSize = 0;
+            recipe.fnAttach = [args](GameObject& a_obj,BulkArena*)
+                {
+                    std::apply([&a_obj](const auto&... a_ctorArgs) { a_obj.AddComponent<CompType>(a_ctorArgs...); },args);
+                };
+        }
+        m_vRecipes.push_back(std::move(recipe));
+        return *this;
+    }
+
+    const std::string& GetName() const
+    {
+        return m_name;
+    }
+
+    // オブジェクト1つ分を作るのに使うおおよそのメモリの大きさ (アリーナの大きさを決めるのに使う)
+    std::size_t GetBytesPerInstance() const
+    {
+        std::size_t size = sizeof(GameObject) + alignof(GameObject) + SHARED_CONTROL_BLOCK_SIZE;
+        for(const Recipe& recipe : m_vRecipes)
+        {
+            size += recipe.allocSize;
+        }
+        return size;
+    }
+
+    // 記録したコンポーネントを引数のオブジェクトに追加する (コンポーネントのメモリはアリーナから切り出す)
+    void Apply(GameObject& a_obj,BulkArena* a_pArena) const
+    {
+        a_obj.ReserveComponents(m_vRecipes.size());
+        for(const Recipe& recipe : m_vRecipes)
+        {
+            recipe.fnAttach(a_obj,a_pArena);
+        }
+    }
+
+private:
+    // allocate_shared が値と一緒に置く制御ブロック(参照カウントとアロケータ)のおおよその大きさ
+    static constexpr std::size_t SHARED_CONTROL_BLOCK_SIZE = 32;
+
+    // 1つのコンポーネントの作り方
+    struct Recipe
+    {
+        std::size_t allocSize = 0;
+        std::function<void(GameObject&,BulkArena*)> fnAttach;
+    };
+
+    std::string m_name;
+    std::vector<Recipe> m_vRecipes;
+};
+
+#endif // PREFAB_HPP
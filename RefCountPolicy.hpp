@@ -0,0 +1,520 @@
+﻿#ifndef REF_COUNT_POLICY_HPP
+#define REF_COUNT_POLICY_HPP
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+
+
+// GameObject とコンポーネントの所有に使う参照カウント付きポインタの切り替え
+// 既定では std::shared_ptr/std::weak_ptr をそのまま使う
+// GAMEOBJECT_NONATOMIC_REFCOUNT を 1 に定義してビルドすると、参照カウントをアトミック操作しない
+// LocalSharedPtr/LocalWeakPtr に置き換わる (lock() やコピーのたびのアトミック命令が無くなる)
+// 所有の仕方と weak_ptr の振る舞い(持ち主が破棄されたら lock() が空を返す)は同じ
+// 参照カウントを複数のスレッドから操作できなくなるため、1つのスレッドだけでワールドを扱う場合にのみ使うこと
+// (ObjectManager の更新スレッドの数と破棄用のスレッドは使えなくなる)
+#ifndef GAMEOBJECT_NONATOMIC_REFCOUNT
+#define GAMEOBJECT_NONATOMIC_REFCOUNT 0
+#endif
+
+
+#if GAMEOBJECT_NONATOMIC_REFCOUNT
+
+namespace RefCountDetail
+{
+    // 参照カウントと、値の破棄・ブロックの解放の仕方
+    // 強参照が全て無くなったら値を破棄し、弱参照も全て無くなったらブロックを解放する
+    class ControlBlock
+    {
+    public:
+        void AddStrong()
+        {
+            ++m_strongCount;
+        }
+
+        // 強参照が無くなれば値を破棄する (弱参照の分として持っていた1つも減らす)
+        void ReleaseStrong()
+        {
+            if(--m_strongCount == 0)
+            {
+                DestroyValue();
+                ReleaseWeak();
+            }
+        }
+
+        // 強参照が残っていれば1つ増やして true を返す (lock 用)
+        bool TryAddStrong()
+        {
+            if(m_strongCount == 0)
+            {
+                return false;
+            }
+            ++m_strongCount;
+            return true;
+        }
+
+        void AddWeak()
+        {
+            ++m_weakCount;
+        }
+
+        void ReleaseWeak()
+        {
+            if(--m_weakCount == 0)
+            {
+                DestroyBlock();
+            }
+        }
+
+        std::uint32_t GetStrongCount() const
+        {
+            return m_strongCount;
+        }
+
+    protected:
+        virtual ~ControlBlock() = default;
+        virtual void DestroyValue() = 0;
+        virtual void DestroyBlock() = 0;
+
+    private:
+        std::uint32_t m_strongCount = 1;
+        std::uint32_t m_weakCount = 1; // 強参照が残っている間は、まとめて1つとして数える
+    };
+
+    // 値を同じ確保の中に置くブロック (MakeShared/AllocateShared 用)
+    template<typename ValueType,typename AllocType>
+    class InplaceControlBlock final : public ControlBlock
+    {
+    public:
+        template<typename...ArgTypes>
+        InplaceControlBlock(const AllocType& a_alloc,ArgTypes&&... a_args)
+            : m_alloc(a_alloc)
+        {
+            ::new(static_cast<void*>(&m_storage)) ValueType(std::forward<ArgTypes>(a_args)...);
+        }
+
+        ValueType* GetValue()
+        {
+            return std::launder(reinterpret_cast<ValueType*>(&m_storage));
+        }
+
+    private:
+        using BlockAlloc = typename std::allocator_traits<AllocType>::template rebind_alloc<InplaceControlBlock>;
+
+        void DestroyValue() override
+        {
+            GetValue()->~ValueType();
+        }
+
+        void DestroyBlock() override
+        {
+            BlockAlloc alloc(m_alloc);
+            this->~InplaceControlBlock();
+            std::allocator_traits<BlockAlloc>::deallocate(alloc,this,1);
+        }
+
+        AllocType m_alloc;
+        std::aligned_storage_t<sizeof(ValueType),alignof(ValueType)> m_storage;
+    };
+
+    // new で確保された値を指すブロック (生ポインタから作る場合)
+    template<typename ValueType>
+    class PointerControlBlock final : public ControlBlock
+    {
+    public:
+        explicit PointerControlBlock(ValueType* a_pValue)
+            : m_pValue(a_pValue)
+        {
+        }
+
+    private:
+        void DestroyValue() override
+        {
+            delete m_pValue;
+        }
+
+        void DestroyBlock() override
+        {
+            delete this;
+        }
+
+        ValueType* m_pValue;
+    };
+}
+
+
+template<typename ValueType>
+class LocalWeakPtr;
+
+template<typename ValueType>
+class LocalEnableSharedFromThis;
+
+
+// 参照カウントをアトミック操作しない std::shared_ptr 相当のポインタ
+template<typename ValueType>
+class LocalSharedPtr
+{
+public:
+    using element_type = ValueType;
+
+    constexpr LocalSharedPtr() noexcept = default;
+    constexpr LocalSharedPtr(std::nullptr_t) noexcept {}
+
+    template<typename OtherType,typename = std::enable_if_t<std::is_convertible<OtherType*,ValueType*>::value>>
+    explicit LocalSharedPtr(OtherType* a_pValue)
+        : m_pValue(a_pValue)
+    {
+        if(a_pValue != nullptr)
+        {
+            m_pBlock = new RefCountDetail::PointerControlBlock<OtherType>(a_pValue);
+            SetWeakThis(a_pValue);
+        }
+    }
+
+    LocalSharedPtr(const LocalSharedPtr& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddStrong();
+    }
+
+    LocalSharedPtr(LocalSharedPtr&& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        a_other.m_pValue = nullptr;
+        a_other.m_pBlock = nullptr;
+    }
+
+    template<typename OtherType,typename = std::enable_if_t<std::is_convertible<OtherType*,ValueType*>::value>>
+    LocalSharedPtr(const LocalSharedPtr<OtherType>& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddStrong();
+    }
+
+    template<typename OtherType,typename = std::enable_if_t<std::is_convertible<OtherType*,ValueType*>::value>>
+    LocalSharedPtr(LocalSharedPtr<OtherType>&& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        a_other.m_pValue = nullptr;
+        a_other.m_pBlock = nullptr;
+    }
+
+    // 参照カウントは a_other と共有し、別のポインタを指す (キャスト用)
+    template<typename OtherType>
+    LocalSharedPtr(const LocalSharedPtr<OtherType>& a_other,ValueType* a_pValue) noexcept
+        : m_pValue(a_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddStrong();
+    }
+
+    template<typename OtherType>
+    LocalSharedPtr(LocalSharedPtr<OtherType>&& a_other,ValueType* a_pValue) noexcept
+        : m_pValue(a_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        a_other.m_pValue = nullptr;
+        a_other.m_pBlock = nullptr;
+    }
+
+    ~LocalSharedPtr()
+    {
+        if(m_pBlock) m_pBlock->ReleaseStrong();
+    }
+
+    LocalSharedPtr& operator=(LocalSharedPtr a_other) noexcept
+    {
+        swap(a_other);
+        return *this;
+    }
+
+    void reset() noexcept
+    {
+        LocalSharedPtr().swap(*this);
+    }
+
+    void swap(LocalSharedPtr& a_other) noexcept
+    {
+        std::swap(m_pValue,a_other.m_pValue);
+        std::swap(m_pBlock,a_other.m_pBlock);
+    }
+
+    ValueType* get() const noexcept
+    {
+        return m_pValue;
+    }
+
+    template<typename Type = ValueType>
+    std::enable_if_t<!std::is_void<Type>::value,Type&> operator*() const noexcept
+    {
+        return *m_pValue;
+    }
+
+    ValueType* operator->() const noexcept
+    {
+        return m_pValue;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_pValue != nullptr;
+    }
+
+    long use_count() const noexcept
+    {
+        return m_pBlock ? static_cast<long>(m_pBlock->GetStrongCount()) : 0;
+    }
+
+    template<typename OtherType>
+    bool operator==(const LocalSharedPtr<OtherType>& a_other) const noexcept { return m_pValue == a_other.get(); }
+    template<typename OtherType>
+    bool operator!=(const LocalSharedPtr<OtherType>& a_other) const noexcept { return m_pValue != a_other.get(); }
+    bool operator==(std::nullptr_t) const noexcept { return m_pValue == nullptr; }
+    bool operator!=(std::nullptr_t) const noexcept { return m_pValue != nullptr; }
+
+private:
+    template<typename> friend class LocalSharedPtr;
+    template<typename> friend class LocalWeakPtr;
+    template<typename Type,typename AllocType,typename...ArgTypes>
+    friend LocalSharedPtr<Type> AllocateShared(const AllocType&,ArgTypes&&...);
+
+    LocalSharedPtr(ValueType* a_pValue,RefCountDetail::ControlBlock* a_pBlock) noexcept
+        : m_pValue(a_pValue),m_pBlock(a_pBlock)
+    {
+    }
+
+    // LocalEnableSharedFromThis を継承していれば、自身を指す弱参照をセットする
+    template<typename OtherType>
+    void SetWeakThis(OtherType* a_pValue)
+    {
+        AssignWeakThis(a_pValue);
+    }
+
+    template<typename BaseType>
+    void AssignWeakThis(LocalEnableSharedFromThis<BaseType>* a_pBase)
+    {
+        a_pBase->m_wpThis = LocalSharedPtr<BaseType>(*this,static_cast<BaseType*>(a_pBase));
+    }
+
+    void AssignWeakThis(...)
+    {
+    }
+
+    ValueType* m_pValue = nullptr;
+    RefCountDetail::ControlBlock* m_pBlock = nullptr;
+};
+
+
+// 参照カウントをアトミック操作しない std::weak_ptr 相当のポインタ
+template<typename ValueType>
+class LocalWeakPtr
+{
+public:
+    using element_type = ValueType;
+
+    constexpr LocalWeakPtr() noexcept = default;
+
+    template<typename OtherType,typename = std::enable_if_t<std::is_convertible<OtherType*,ValueType*>::value>>
+    LocalWeakPtr(const LocalSharedPtr<OtherType>& a_spOther) noexcept
+        : m_pValue(a_spOther.m_pValue),m_pBlock(a_spOther.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddWeak();
+    }
+
+    LocalWeakPtr(const LocalWeakPtr& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddWeak();
+    }
+
+    LocalWeakPtr(LocalWeakPtr&& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        a_other.m_pValue = nullptr;
+        a_other.m_pBlock = nullptr;
+    }
+
+    template<typename OtherType,typename = std::enable_if_t<std::is_convertible<OtherType*,ValueType*>::value>>
+    LocalWeakPtr(const LocalWeakPtr<OtherType>& a_other) noexcept
+        : m_pValue(a_other.m_pValue),m_pBlock(a_other.m_pBlock)
+    {
+        if(m_pBlock) m_pBlock->AddWeak();
+    }
+
+    ~LocalWeakPtr()
+    {
+        if(m_pBlock) m_pBlock->ReleaseWeak();
+    }
+
+    LocalWeakPtr& operator=(LocalWeakPtr a_other) noexcept
+    {
+        swap(a_other);
+        return *this;
+    }
+
+    void reset() noexcept
+    {
+        LocalWeakPtr().swap(*this);
+    }
+
+    void swap(LocalWeakPtr& a_other) noexcept
+    {
+        std::swap(m_pValue,a_other.m_pValue);
+        std::swap(m_pBlock,a_other.m_pBlock);
+    }
+
+    // 値が残っていればそれを指す強参照を返す (破棄済みなら空)
+    LocalSharedPtr<ValueType> lock() const noexcept
+    {
+        if(m_pBlock != nullptr && m_pBlock->TryAddStrong())
+        {
+            return LocalSharedPtr<ValueType>(m_pValue,m_pBlock);
+        }
+        return LocalSharedPtr<ValueType>();
+    }
+
+    bool expired() const noexcept
+    {
+        return m_pBlock == nullptr || m_pBlock->GetStrongCount() == 0;
+    }
+
+    long use_count() const noexcept
+    {
+        return m_pBlock ? static_cast<long>(m_pBlock->GetStrongCount()) : 0;
+    }
+
+private:
+    template<typename> friend class LocalWeakPtr;
+
+    ValueType* m_pValue = nullptr;
+    RefCountDetail::ControlBlock* m_pBlock = nullptr;
+};
+
+
+// std::enable_shared_from_this 相当
+template<typename ValueType>
+class LocalEnableSharedFromThis
+{
+public:
+    LocalSharedPtr<ValueType> shared_from_this()
+    {
+        return m_wpThis.lock();
+    }
+
+    LocalWeakPtr<ValueType> weak_from_this() const noexcept
+    {
+        return m_wpThis;
+    }
+
+protected:
+    LocalEnableSharedFromThis() = default;
+    LocalEnableSharedFromThis(const LocalEnableSharedFromThis&) noexcept {}
+    LocalEnableSharedFromThis& operator=(const LocalEnableSharedFromThis&) noexcept { return *this; }
+    ~LocalEnableSharedFromThis() = default;
+
+private:
+    template<typename> friend class LocalSharedPtr;
+
+    LocalWeakPtr<ValueType> m_wpThis;
+};
+
+
+template<typename ValueType>
+using SharedPtr = LocalSharedPtr<ValueType>;
+template<typename ValueType>
+using WeakPtr = LocalWeakPtr<ValueType>;
+template<typename ValueType>
+using EnableSharedFromThis = LocalEnableSharedFromThis<ValueType>;
+
+// 値とブロックを引数のアロケータで1回で確保する
+template<typename ValueType,typename AllocType,typename...ArgTypes>
+LocalSharedPtr<ValueType> AllocateShared(const AllocType& a_alloc,ArgTypes&&... a_args)
+{
+    using Block = RefCountDetail::InplaceControlBlock<ValueType,AllocType>;
+    using BlockAlloc = typename std::allocator_traits<AllocType>::template rebind_alloc<Block>;
+    BlockAlloc alloc(a_alloc);
+    Block* pBlock = std::allocator_traits<BlockAlloc>::allocate(alloc,1);
+    try
+    {
+        ::new(static_cast<void*>(pBlock)) Block(a_alloc,std::forward<ArgTypes>(a_args)...);
+    }
+    catch(...)
+    {
+        std::allocator_traits<BlockAlloc>::deallocate(alloc,pBlock,1);
+        throw;
+    }
+    LocalSharedPtr<ValueType> spValue(pBlock->GetValue(),pBlock);
+    spValue.SetWeakThis(pBlock->GetValue());
+    return spValue;
+}
+
+template<typename ValueType,typename...ArgTypes>
+LocalSharedPtr<ValueType> MakeShared(ArgTypes&&... a_args)
+{
+    return AllocateShared<ValueType>(std::allocator<ValueType>(),std::forward<ArgTypes>(a_args)...);
+}
+
+template<typename ValueType,typename OtherType>
+LocalSharedPtr<ValueType> StaticPointerCast(const LocalSharedPtr<OtherType>& a_spOther) noexcept
+{
+    return LocalSharedPtr<ValueType>(a_spOther,static_cast<ValueType*>(a_spOther.get()));
+}
+
+template<typename ValueType,typename OtherType>
+LocalSharedPtr<ValueType> StaticPointerCast(LocalSharedPtr<OtherType>&& a_spOther) noexcept
+{
+    ValueType* pValue = static_cast<ValueType*>(a_spOther.get());
+    return LocalSharedPtr<ValueType>(std::move(a_spOther),pValue);
+}
+
+template<typename ValueType,typename OtherType>
+LocalSharedPtr<ValueType> DynamicPointerCast(const LocalSharedPtr<OtherType>& a_spOther) noexcept
+{
+    ValueType* pValue = dynamic_cast<ValueType*>(a_spOther.get());
+    return pValue != nullptr ? LocalSharedPtr<ValueType>(a_spOther,pValue) : LocalSharedPtr<ValueType>();
+}
+
+#else // GAMEOBJECT_NONATOMIC_REFCOUNT
+
+template<typename ValueType>
+using SharedPtr = std::shared_ptr<ValueType>;
+template<typename ValueType>
+using WeakPtr = std::weak_ptr<ValueType>;
+template<typename ValueType>
+using EnableSharedFromThis = std::enable_shared_from_this<ValueType>;
+
+template<typename ValueType,typename AllocType,typename...ArgTypes>
+SharedPtr<ValueType> AllocateShared(const AllocType& a_alloc,ArgTypes&&... a_args)
+{
+    return std::allocate_shared<ValueType>(a_alloc,std::forward<ArgTypes>(a_args)...);
+}
+
+template<typename ValueType,typename...ArgTypes>
+SharedPtr<ValueType> MakeShared(ArgTypes&&... a_args)
+{
+    return std::make_shared<ValueType>(std::forward<ArgTypes>(a_args)...);
+}
+
+template<typename ValueType,typename OtherType>
+SharedPtr<ValueType> StaticPointerCast(const SharedPtr<OtherType>& a_spOther) noexcept
+{
+    return std::static_pointer_cast<ValueType>(a_spOther);
+}
+
+template<typename ValueType,typename OtherType>
+SharedPtr<ValueType> StaticPointerCast(SharedPtr<OtherType>&& a_spOther) noexcept
+{
+    return std::static_pointer_cast<ValueType>(std::move(a_spOther));
+}
+
+template<typename ValueType,typename OtherType>
+SharedPtr<ValueType> DynamicPointerCast(const SharedPtr<OtherType>& a_spOther) noexcept
+{
+    return std::dynamic_pointer_cast<ValueType>(a_spOther);
+}
+
+#endif // GAMEOBJECT_NONATOMIC_REFCOUNT
+
+#endif // REF_COUNT_POLICY_HPP
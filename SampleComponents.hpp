@@ -8,6 +8,9 @@
 // 位置情報を持ち、移動するコンポーネント
 class TransformComponent : public ComponentBase {
 public:
+    // OnUpdate は自身のデータだけを書き換えるので、複数のスレッドから同時に呼んで良い
+    static constexpr bool THREAD_SAFE = true;
+
     float x = 0.0f;
     float y = 0.0f;
     float speed = 50.0f; // 移動速度（角度変化の速さなど）
@@ -17,15 +20,14 @@ public:
     TransformComponent(float startX = 0.0f, float startY = 0.0f, float s = 50.0f, float r = 5.0f)
         : x(startX), y(startY), speed(s), radius(r), initialX(startX), initialY(startY) {}
 
-    void OnStart() override {
-        if (auto owner = GetOwner().lock()) {
-            std::cout << "[" << owner->GetName() << ".Transform] Started. Initial Pos: (" << x << ", " << y << "), Speed: " << speed << ", Radius: " << radius << std::endl;
-        }
+    void OnStart(const UpdateContext& ctx) override {
+        // 持ち主は UpdateContext から受け取る (lock() しない)
+        std::cout << "[" << ctx.GetOwner().GetName() << ".Transform] Started. Initial Pos: (" << x << ", " << y << "), Speed: " << speed << ", Radius: " << radius << std::endl;
     }
 
-    void OnUpdate() override {
-        // 毎フレーム角度を更新
-        current_angle_deg += speed * 0.016f; // 0.016f は約60FPS時の1フレーム時間と仮定
+    void OnUpdate(const UpdateContext& ctx) override {
+        // 毎フレーム角度を更新 (前のフレームからの経過時間だけ進める)
+        current_angle_deg += speed * ctx.GetDeltaTime();
         if (current_angle_deg >= 360.0f) {
             current_angle_deg -= 360.0f;
         }
@@ -49,14 +51,16 @@ private:
 // オブジェクト情報を表示するコンポーネント
 class RendererComponent : public ComponentBase {
 public:
-    void OnPostUpdate() override { // Update後の方が位置が確定している
-        auto owner_sp = GetOwner().lock(); // weak_ptr から shared_ptr を取得
-        if (!owner_sp) return;
+    // TransformComponent への依存を宣言する (持ち主が追加/削除のたびに解決し直す)
+    void DeclareDependencies(ComponentDependencyList& a_list) override {
+        a_list.Add(transform);
+    }
+
+    void OnPostUpdate(const UpdateContext& ctx) override { // Update後の方が位置が確定している
+        GameObject* owner_sp = &ctx.GetOwner(); // 毎フレーム呼ばれるので lock() せず UpdateContext から取得
 
-        // TransformComponent を取得試行
- 
-       auto transform_wp = owner_sp->GetComponent<TransformComponent>();
-        auto transform_sp = transform_wp.lock();
+        // TransformComponent は解決済みのポインタを使う (毎フレーム探さない)
+        TransformComponent* transform_sp = transform.Get();
 
         if (transform_sp) {
             std::cout << "[" << owner_sp->GetName() << ".Renderer] Displaying at Pos: ("
@@ -72,6 +76,9 @@ public:
             std::cout << "[" << owner->GetName() << ".Renderer] Released." << std::endl;
         }
     }
+
+private:
+    Requires<TransformComponent> transform;
 };
 
 // 特定の条件でGameObjectを非アクティブにするコンポーネント (入力シミュレーション)
@@ -90,7 +97,7 @@ public:
 
     void OnUpdate() override {
         current_frame++;
-        auto owner_sp = GetOwner().lock();
+        GameObject* owner_sp = GetOwnerPtr(); // 毎フレーム呼ばれるので lock() せず直接取得
         if (!owner_sp) return;
 
         if (current_frame >= frame_to_deactivate) {
@@ -0,0 +1,155 @@
+﻿#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#include "ObjectHandle.hpp"
+
+
+
+// 値を隙間なく詰めた配列に格納し、番号と世代のハンドルで引けるようにするコンテナ
+// 追加・削除・ハンドルからの取得は全てO(1)で、値は常に連続したメモリに並ぶため先頭から速く辿れる
+// 削除は末尾の値を空いた位置へ移動して詰めるので、値の並び順は変わる (ハンドルは変わらない)
+// 削除された番号は世代を進めてから再利用するため、古いハンドルでは取得できない
+template<typename ValueType>
+class SlotMap
+{
+public:
+    // 値を追加し、そのハンドルを返す
+    template<typename...ArgTypes>
+    ObjectHandle Insert(ArgTypes&&... a_args)
+    {
+        ObjectIndex index;
+        if(!m_vFreeIndices.empty())
+        {
+            index = m_vFreeIndices.back();
+            m_vFreeIndices.pop_back();
+        }
+        else
+        {
+            index = static_cast<ObjectIndex>(m_vSlots.size());
+            m_vSlots.emplace_back();
+        }
+
+        Slot& slot = m_vSlots[index];
+        slot.dense = static_cast<std::uint32_t>(m_vDense.size());
+        m_vDense.emplace_back(std::forward<ArgTypes>(a_args)...);
+        m_vDenseToIndex.push_back(index);
+        return ObjectHandle{ index,slot.generation };
+    }
+
+    // ハンドルが指す値を削除する (既に削除されていれば何もしない)
+    // 値を取り除いてから破棄するので、値のデストラクタの中からこのコンテナを操作しても良い
+    bool Erase(ObjectHandle a_handle)
+    {
+        if(!Contains(a_handle))
+        {
+            return false;
+        }
+
+        Slot& slot = m_vSlots[a_handle.index];
+        std::uint32_t dense = slot.dense;
+        std::uint32_t last = static_cast<std::uint32_t>(m_vDense.size() - 1);
+
+        ValueType value(std::move(m_vDense[dense]));
+        if(dense != last)
+        {
+            m_vDense[dense] = std::move(m_vDense[last]);
+            m_vDenseToIndex[dense] = m_vDenseToIndex[last];
+            m_vSlots[m_vDenseToIndex[dense]].dense = dense;
+        }
+        m_vDense.pop_back();
+        m_vDenseToIndex.pop_back();
+
+        slot.dense = INVALID_DENSE;
+        ++slot.generation;
+        m_vFreeIndices.push_back(a_handle.index);
+        return true;
+    }
+
+    // 全ての値を削除する (全てのハンドルが無効になる)
+    void Clear()
+    {
+        std::vector<ValueType> vDense;
+        vDense.swap(m_vDense);
+        for(ObjectIndex index : m_vDenseToIndex)
+        {
+            m_vSlots[index].dense = INVALID_DENSE;
+            ++m_vSlots[index].generation;
+            m_vFreeIndices.push_back(index);
+        }
+        m_vDenseToIndex.clear();
+        vDense.clear();
+    }
+
+    // ハンドルが指す値がまだ存在しているか
+    bool Contains(ObjectHandle a_handle) const
+    {
+        return a_handle.index < m_vSlots.size()
+            && m_vSlots[a_handle.index].generation == a_handle.generation
+            && m_vSlots[a_handle.index].dense != INVALID_DENSE;
+    }
+
+    // ハンドルが指す値を取得する (無ければnullptr)
+    // 追加・削除で値の位置が変わるため、返したポインタを保持し続けないこと
+    ValueType* Find(ObjectHandle a_handle)
+    {
+        return Contains(a_handle) ? &m_vDense[m_vSlots[a_handle.index].dense] : nullptr;
+    }
+
+    const ValueType* Find(ObjectHandle a_handle) const
+    {
+        return Contains(a_handle) ? &m_vDense[m_vSlots[a_handle.index].dense] : nullptr;
+    }
+
+    // 格納している値の数
+    std::size_t GetCount() const
+    {
+        return m_vDense.size();
+    }
+
+    // 隙間なく並んだ値の配列 (先頭から順に辿ることで全ての値を処理できる)
+    std::vector<ValueType>& GetDense()
+    {
+        return m_vDense;
+    }
+
+    // GetDense() の引数の位置の値を指すハンドル
+    ObjectHandle GetHandle(std::size_t a_dense) const
+    {
+        ObjectIndex index = m_vDenseToIndex[a_dense];
+        return ObjectHandle{ index,m_vSlots[index].generation };
+    }
+
+    // 値の数の上限を見込んで、あらかじめ領域を確保する
+    void Reserve(std::size_t a_count)
+    {
+        m_vSlots.reserve(a_count);
+        m_vDense.reserve(a_count);
+        m_vDenseToIndex.reserve(a_count);
+    }
+
+private:
+    // 番号側で値を持っていないことを表す値
+    static constexpr std::uint32_t INVALID_DENSE = static_cast<std::uint32_t>(-1);
+
+    // 番号ごとの、値の位置と世代
+    struct Slot
+    {
+        std::uint32_t dense = INVALID_DENSE;
+        std::uint32_t generation = 1; // 0は「一度も割り振られていない」を表すので1から始める
+    };
+
+    // 番号を添え字とした配列と、再利用できる番号
+    std::vector<Slot> m_vSlots;
+    std::vector<ObjectIndex> m_vFreeIndices;
+
+    // 値と、その値の番号 (同じ位置同士が対応する)
+    std::vector<ValueType> m_vDense;
+    std::vector<ObjectIndex> m_vDenseToIndex;
+};
+
+#endif // SLOT_MAP_HPP
@@ -0,0 +1,254 @@
+﻿#ifndef SYSTEM_SCHEDULER_HPP
+#define SYSTEM_SCHEDULER_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#include "ComponentTypeRegistry.hpp"
+#include "ComponentHook.hpp"
+#include "ComponentPool.hpp"
+#include "ThreadPool.hpp"
+
+
+
+// 前方宣言
+class ObjectManager;
+
+
+// システムが読むコンポーネントの型 (例: SystemReads<TransformComponent>)
+template<typename...Types>
+struct SystemReads {};
+
+// システムが書き換えるコンポーネントの型 (例: SystemWrites<TransformComponent>)
+template<typename...Types>
+struct SystemWrites {};
+
+// コンポーネントやオブジェクトの追加/削除を行うシステムが SystemWrites に含める印
+// (例: SystemWrites<TransformComponent, SystemStructuralChange>)
+// 追加/削除はオブジェクトのコンポーネントの配列や型ごとのプールを書き換えるので、
+// この印を持つシステムは他のどのシステムとも同時に実行しない
+struct SystemStructuralChange {};
+
+
+// 読む型と書く型を宣言した処理(システム)をまとめて実行するクラス
+// 同じ型を書くシステム同士、または一方が書き他方が読むシステム同士は登録した順に実行し、
+// それ以外のシステムはスレッドプールがあれば同時に実行する
+// システムからは ObjectManager::ForEach/ForEachComponent などで宣言した型だけを扱うこと
+// コンポーネントやオブジェクトの追加/削除は SystemStructuralChange を宣言したシステムでだけ行うこと
+// (宣言せずに他のシステムと同時に実行している間に行うと、デバッグビルドでは assert で止まる)
+class SystemScheduler
+{
+public:
+    using SystemFunc = std::function<void(ObjectManager&)>;
+
+    // システムを登録する
+    // 型IDはここで求めておく (システムの実行中に複数のスレッドから新しい型を登録しないようにするため)
+    template<typename ReadList,typename WriteList,typename Func>
+    void AddSystem(std::string_view a_name,ComponentHookList a_phase,Func&& a_func)
+    {
+        System system;
+        system.name = a_name;
+        system.phase = a_phase;
+        system.func = std::forward<Func>(a_func);
+        system.vReadIDs = GetTypeIDs(ReadList());
+        system.vWriteIDs = GetTypeIDs(WriteList());
+        system.isStructuralChange = HasStructuralChange(WriteList());
+        m_vSystems.push_back(std::move(system));
+    }
+
+    // 引数の名前のシステムを取り除く
+    void RemoveSystem(std::string_view a_name)
+    {
+        m_vSystems.erase(std::remove_if(m_vSystems.begin(),m_vSystems.end(),
+            [a_name](const System& a_system) { return a_system.name == a_name; }),m_vSystems.end());
+    }
+
+    // 登録されているシステムの数
+    std::size_t GetSystemCount() const
+    {
+        return m_vSystems.size();
+    }
+
+    // 引数の処理の後に実行するシステムを全て実行する
+    // 実行のたびに、アクセスする型が衝突するシステム同士の依存関係を作り直す
+    void Run(ComponentHookList a_phase,ObjectManager& a_world,ThreadPool* a_pThreadPool)
+    {
+        m_vRunSystems.clear();
+        for(System& system : m_vSystems)
+        {
+            if(system.phase == a_phase)
+            {
+                m_vRunSystems.push_back(&system);
+            }
+        }
+        if(m_vRunSystems.empty())
+        {
+            return;
+        }
+
+        // 同時に実行できなければ登録した順に実行する (登録順は依存関係を満たしている)
+        if(a_pThreadPool == nullptr || a_pThreadPool->GetThreadCount() < 2 || m_vRunSystems.size() < 2)
+        {
+            for(System* pSystem : m_vRunSystems)
+            {
+                pSystem->func(a_world);
+            }
+            return;
+        }
+
+        BuildGraph();
+        RunGraph(a_world,*a_pThreadPool);
+    }
+
+private:
+    // 登録されたシステム
+    struct System
+    {
+        std::string name;
+        ComponentHookList phase = HOOK_LIST_UPDATE;
+        SystemFunc func;
+        std::vector<ComponentTypeID> vReadIDs;  // 昇順
+        std::vector<ComponentTypeID> vWriteIDs; // 昇順
+        bool isStructuralChange = false; // SystemStructuralChange を宣言しているか
+    };
+
+    // 型のIDを配列に加える (SystemStructuralChange はコンポーネントではないので加えない)
+    template<typename Type>
+    static void AppendTypeID(std::vector<ComponentTypeID>& a_vIDs)
+    {
+        if constexpr(!std::is_same<Type,SystemStructuralChange>::value)
+        {
+            a_vIDs.push_back(ComponentTypeRegistry::GetID<Type>());
+        }
+    }
+
+    template<template<typename...> class ListType,typename...Types>
+    static std::vector<ComponentTypeID> GetTypeIDs(ListType<Types...>)
+    {
+        std::vector<ComponentTypeID> vIDs;
+        vIDs.reserve(sizeof...(Types));
+        (AppendTypeID<Types>(vIDs),...);
+        std::sort(vIDs.begin(),vIDs.end());
+        return vIDs;
+    }
+
+    template<typename...Types>
+    static bool HasStructuralChange(SystemWrites<Types...>)
+    {
+        return (std::is_same<Types,SystemStructuralChange>::value || ...);
+    }
+
+    // 昇順に並んだ2つの配列に共通の値があるか
+    static bool Intersects(const std::vector<ComponentTypeID>& a_vLeft,const std::vector<ComponentTypeID>& a_vRight)
+    {
+        auto itrL = a_vLeft.begin();
+        auto itrR = a_vRight.begin();
+        while(itrL != a_vLeft.end() && itrR != a_vRight.end())
+        {
+            if(*itrL == *itrR) return true;
+            if(*itrL < *itrR) ++itrL;
+            else ++itrR;
+        }
+        return false;
+    }
+
+    // 2つのシステムを同時に実行してはいけないか
+    // (どちらかが追加/削除を行う、または一方が書く型をもう一方が読むか書く)
+    static bool Conflicts(const System& a_first,const System& a_second)
+    {
+        return a_first.isStructuralChange || a_second.isStructuralChange
+            || Intersects(a_first.vWriteIDs,a_second.vWriteIDs)
+            || Intersects(a_first.vWriteIDs,a_second.vReadIDs)
+            || Intersects(a_first.vReadIDs,a_second.vWriteIDs);
+    }
+
+    // 実行するシステムの依存関係を作る
+    // 後に登録されたシステムは、衝突する先のシステムが全て終わるまで実行しない
+    void BuildGraph()
+    {
+        std::size_t count = m_vRunSystems.size();
+        if(m_dependencyCapacity < count)
+        {
+            m_upDependencyCounts = std::make_unique<std::atomic<std::uint32_t>[]>(count);
+            m_dependencyCapacity = count;
+        }
+
+        // 依存されている側 → 依存している側 の辺を、システムごとに続けて並べる
+        m_vDependents.clear();
+        m_vDependentsBegin.assign(count + 1,0);
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            m_upDependencyCounts[i].store(0,std::memory_order_relaxed);
+        }
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            m_vDependentsBegin[i] = static_cast<std::uint32_t>(m_vDependents.size());
+            for(std::size_t j = i + 1; j < count; ++j)
+            {
+                if(Conflicts(*m_vRunSystems[i],*m_vRunSystems[j]))
+                {
+                    m_vDependents.push_back(static_cast<std::uint32_t>(j));
+                    m_upDependencyCounts[j].fetch_add(1,std::memory_order_relaxed);
+                }
+            }
+        }
+        m_vDependentsBegin[count] = static_cast<std::uint32_t>(m_vDependents.size());
+    }
+
+    // 依存しているシステムが全て終わったものから、スレッドプールの各スレッドで実行する
+    // 最初は依存の無いシステムだけを積み、終わったシステムが依存されている先の数を減らして、0になったものを積む
+    // 追加/削除を宣言していないシステムの間は、そのスレッドでの追加/削除を禁止しておく
+    void RunGraph(ObjectManager& a_world,ThreadPool& a_threadPool)
+    {
+        std::size_t count = m_vRunSystems.size();
+
+        m_vReady.clear();
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            if(m_upDependencyCounts[i].load(std::memory_order_relaxed) == 0)
+            {
+                m_vReady.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+
+        a_threadPool.RunTaskGraph(count,m_vReady.data(),m_vReady.size(),[this,&a_world](std::uint32_t a_index,auto& a_graph)
+            {
+                System& system = *m_vRunSystems[a_index];
+                {
+                    StructuralChangeLock lock(!system.isStructuralChange);
+                    system.func(a_world);
+                }
+
+                for(std::uint32_t e = m_vDependentsBegin[a_index]; e < m_vDependentsBegin[a_index + 1]; ++e)
+                {
+                    std::uint32_t dependent = m_vDependents[e];
+                    if(m_upDependencyCounts[dependent].fetch_sub(1,std::memory_order_acq_rel) == 1)
+                    {
+                        a_graph.Enqueue(dependent);
+                    }
+                }
+            });
+    }
+
+private:
+    // 登録されたシステム (登録した順)
+    std::vector<System> m_vSystems;
+
+    // 以下は Run のたびに作り直す作業用の配列 (確保し直さないようメンバに持つ)
+    std::vector<System*> m_vRunSystems;
+    std::vector<std::uint32_t> m_vDependents;
+    std::vector<std::uint32_t> m_vDependentsBegin;
+    std::vector<std::uint32_t> m_vReady;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_upDependencyCounts;
+    std::size_t m_dependencyCapacity = 0;
+};
+
+#endif // SYSTEM_SCHEDULER_HPP
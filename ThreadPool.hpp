@@ -0,0 +1,328 @@
+﻿#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+
+
+// 更新処理を複数のスレッドに分けて行うためのスレッドプール
+// スレッドごとに仕事の両端キューを持ち、自分のキューが空になったら他のスレッドのキューから盗む(ワークスティーリング)
+// ParallelFor を呼んだスレッドも仕事を手伝い、全ての仕事が終わるまで戻らない (処理の区切りとして使える)
+class ThreadPool
+{
+public:
+    // 引数の数だけ作業スレッドを作る (呼び出し元のスレッドと合わせて a_workerCount + 1 個で処理する)
+    explicit ThreadPool(std::size_t a_workerCount)
+    {
+        // 0番は ParallelFor を呼んだスレッド用のキュー
+        for(std::size_t i = 0; i <= a_workerCount; ++i)
+        {
+            m_vQueues.push_back(std::make_unique<WorkQueue>());
+        }
+        for(std::size_t i = 1; i <= a_workerCount; ++i)
+        {
+            m_vThreads.emplace_back([this,i]() { WorkerMain(i); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_isStopping = true;
+        }
+        m_cvWake.notify_all();
+        for(std::thread& thread : m_vThreads)
+        {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 呼び出し元のスレッドも含めた、処理に使うスレッドの数
+    std::size_t GetThreadCount() const
+    {
+        return m_vQueues.size();
+    }
+
+    // [0, a_count) を a_grainSize ずつの範囲に分け、a_func(begin, end) を各スレッドで呼ぶ
+    // 全ての範囲の処理が終わるまで戻らない
+    // 作業スレッドの中から呼ばないこと (入れ子の ParallelFor には対応しない)
+    template<typename Func>
+    void ParallelFor(std::size_t a_count,std::size_t a_grainSize,Func&& a_func)
+    {
+        if(a_count == 0)
+        {
+            return;
+        }
+        a_grainSize = std::max<std::size_t>(a_grainSize,1);
+
+        // 分ける必要が無ければ、このスレッドでそのまま処理する
+        if(m_vThreads.empty() || a_count <= a_grainSize)
+        {
+            a_func(std::size_t(0),a_count);
+            return;
+        }
+
+        std::size_t taskCount = (a_count + a_grainSize - 1) / a_grainSize;
+        std::atomic<std::size_t> remaining(taskCount);
+
+        // 各スレッドのキューへ順に配る (偏りは盗むことで均される)
+        // 取り出す側が先に数を減らしてしまわないよう、積む前に数を増やしておく
+        m_queuedCount.fetch_add(taskCount);
+        for(std::size_t t = 0; t < taskCount; ++t)
+        {
+            Task task;
+            task.pfnRun = &RunRange<std::remove_reference_t<Func>>;
+            task.pContext = &a_func;
+            task.begin = t * a_grainSize;
+            task.end = std::min(task.begin + a_grainSize,a_count);
+            task.pRemaining = &remaining;
+
+            WorkQueue& queue = *m_vQueues[t % m_vQueues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.dqTasks.push_back(task);
+        }
+        {
+            // 眠ろうとしている作業スレッドが通知を取りこぼさないよう、一度ロックを取ってから通知する
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_cvWake.notify_all();
+
+        // このスレッドも仕事を手伝い、全て終わるまで待つ
+        while(remaining.load(std::memory_order_acquire) > 0)
+        {
+            Task task;
+            if(PopTask(0,task) || StealTask(0,task))
+            {
+                RunTask(task);
+            }
+            else
+            {
+                // 残りは他のスレッドが処理中
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // RunTaskGraph の実行中の状態
+    // 仕事の中から Enqueue を呼び、実行できるようになった仕事を積む
+    template<typename Func>
+    class TaskGraph
+    {
+    public:
+        // 引数の番号の仕事を積む (空いているスレッドが取り出して実行する)
+        void Enqueue(std::uint32_t a_index)
+        {
+            Task task;
+            task.pfnRun = &TaskGraph::RunNode;
+            task.pContext = this;
+            task.begin = a_index;
+            task.end = a_index + 1;
+            task.pRemaining = &m_remaining;
+            task.isNotifyFinished = true;
+            m_pThreadPool->PushTask(task);
+        }
+
+    private:
+        friend class ThreadPool;
+
+        TaskGraph(ThreadPool* a_pThreadPool,Func* a_pFunc,std::size_t a_count)
+            : m_pThreadPool(a_pThreadPool)
+            , m_pFunc(a_pFunc)
+            , m_remaining(a_count)
+        {
+        }
+
+        static void RunNode(void* a_pContext,std::size_t a_begin,std::size_t)
+        {
+            TaskGraph& graph = *static_cast<TaskGraph*>(a_pContext);
+            (*graph.m_pFunc)(static_cast<std::uint32_t>(a_begin),graph);
+        }
+
+        ThreadPool* m_pThreadPool;
+        Func* m_pFunc;
+        std::atomic<std::size_t> m_remaining; // まだ終わっていない仕事の数
+    };
+
+    // 依存関係のある a_count 個の仕事を、実行できるようになったものから各スレッドで実行する
+    // 最初は a_pReady の a_readyCount 個の番号だけを積み、a_func(index, graph) の中で
+    // 実行できるようになった番号を graph.Enqueue(index) で積む (全ての番号がちょうど1回ずつ積まれること)
+    // 実行できる仕事が無いスレッドは眠って待つので、長い仕事が終わるのを空回りして待つことは無い
+    // 全ての仕事が終わるまで戻らない。作業スレッドの中から呼ばないこと
+    template<typename Func>
+    void RunTaskGraph(std::size_t a_count,const std::uint32_t* a_pReady,std::size_t a_readyCount,Func&& a_func)
+    {
+        if(a_count == 0)
+        {
+            return;
+        }
+
+        using FuncType = std::remove_reference_t<Func>;
+        TaskGraph<FuncType> graph(this,&a_func,a_count);
+        for(std::size_t i = 0; i < a_readyCount; ++i)
+        {
+            graph.Enqueue(a_pReady[i]);
+        }
+
+        // このスレッドも仕事を手伝い、積まれた仕事が無ければ、新しく積まれるか全て終わるまで眠る
+        while(graph.m_remaining.load(std::memory_order_acquire) > 0)
+        {
+            Task task;
+            if(PopTask(0,task) || StealTask(0,task))
+            {
+                RunTask(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_cvWake.wait(lock,[this,&graph]()
+                {
+                    return graph.m_remaining.load(std::memory_order_acquire) == 0 || m_queuedCount.load() > 0;
+                });
+        }
+    }
+
+private:
+    // 1つの仕事 (関数と、その関数に渡す範囲)
+    struct Task
+    {
+        void (*pfnRun)(void*,std::size_t,std::size_t) = nullptr;
+        void* pContext = nullptr;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        std::atomic<std::size_t>* pRemaining = nullptr;
+        bool isNotifyFinished = false; // 最後の仕事が終わったときに、眠って待っているスレッドを起こすか
+    };
+
+    // スレッドごとの仕事のキュー
+    // 持ち主は後ろから取り出し、他のスレッドは前から盗む (持ち主と盗む側がぶつかりにくい)
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> dqTasks;
+    };
+
+    template<typename Func>
+    static void RunRange(void* a_pContext,std::size_t a_begin,std::size_t a_end)
+    {
+        (*static_cast<Func*>(a_pContext))(a_begin,a_end);
+    }
+
+    void RunTask(const Task& a_task)
+    {
+        a_task.pfnRun(a_task.pContext,a_task.begin,a_task.end);
+        if(a_task.pRemaining->fetch_sub(1,std::memory_order_acq_rel) == 1 && a_task.isNotifyFinished)
+        {
+            // 眠ろうとしているスレッドが通知を取りこぼさないよう、一度ロックを取ってから通知する
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+            }
+            m_cvWake.notify_all();
+        }
+    }
+
+    // 仕事を1つ積み、眠っているスレッドを1つ起こす (積む先はスレッドごとのキューに順に配る)
+    void PushTask(const Task& a_task)
+    {
+        std::size_t queueIndex = m_nextQueue.fetch_add(1,std::memory_order_relaxed) % m_vQueues.size();
+
+        // 取り出す側が先に数を減らしてしまわないよう、積む前に数を増やしておく
+        m_queuedCount.fetch_add(1);
+        {
+            WorkQueue& queue = *m_vQueues[queueIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.dqTasks.push_back(a_task);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_cvWake.notify_one();
+    }
+
+    // 自分のキューの後ろから仕事を取り出す
+    bool PopTask(std::size_t a_queueIndex,Task& a_outTask)
+    {
+        WorkQueue& queue = *m_vQueues[a_queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.dqTasks.empty())
+        {
+            return false;
+        }
+        a_outTask = queue.dqTasks.back();
+        queue.dqTasks.pop_back();
+        m_queuedCount.fetch_sub(1);
+        return true;
+    }
+
+    // 他のスレッドのキューの前から仕事を盗む
+    bool StealTask(std::size_t a_thiefIndex,Task& a_outTask)
+    {
+        for(std::size_t i = 1; i < m_vQueues.size(); ++i)
+        {
+            WorkQueue& queue = *m_vQueues[(a_thiefIndex + i) % m_vQueues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!queue.dqTasks.empty())
+            {
+                a_outTask = queue.dqTasks.front();
+                queue.dqTasks.pop_front();
+                m_queuedCount.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 作業スレッドの処理 (仕事が無い間は眠る)
+    void WorkerMain(std::size_t a_queueIndex)
+    {
+        while(true)
+        {
+            Task task;
+            if(PopTask(a_queueIndex,task) || StealTask(a_queueIndex,task))
+            {
+                RunTask(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_cvWake.wait(lock,[this]() { return m_isStopping || m_queuedCount.load() > 0; });
+            if(m_isStopping)
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    // スレッドごとの仕事のキュー (0番は ParallelFor を呼んだスレッド用)
+    std::vector<std::unique_ptr<WorkQueue>> m_vQueues;
+
+    // 作業スレッド
+    std::vector<std::thread> m_vThreads;
+
+    // キューに積まれている仕事の数 (作業スレッドが眠って良いかの判定に使う)
+    std::atomic<std::size_t> m_queuedCount{ 0 };
+
+    // PushTask で次に積むキュー
+    std::atomic<std::size_t> m_nextQueue{ 0 };
+
+    // 仕事が積まれたことを作業スレッドへ知らせる
+    std::mutex m_sleepMutex;
+    std::condition_variable m_cvWake;
+    bool m_isStopping = false;
+};
+
+#endif // THREAD_POOL_HPP
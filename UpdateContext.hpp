@@ -0,0 +1,86 @@
+﻿#ifndef UPDATE_CONTEXT_HPP
+#define UPDATE_CONTEXT_HPP
+
+#include <cstdint>
+#include <memory_resource>
+
+
+
+// 前方宣言
+class GameObject;
+class ObjectManager;
+
+
+// 1フレーム分の更新で、全てのコンポーネントに共通する情報
+// ObjectManager::UpdateWorld がフレームの始めにセットする
+struct FrameContext
+{
+    // 前のフレームからの経過時間(秒)
+    float deltaTime = 1.0f / 60.0f;
+
+    // UpdateWorld を呼んだ回数 (最初のフレームが0)
+    std::uint64_t frameIndex = 0;
+
+    // 更新しているワールド (ObjectManagerを通さずに更新したときはnullptr)
+    ObjectManager* pWorld = nullptr;
+
+    // そのフレームの間だけ使う一時的なメモリの確保先 (ObjectManagerを通さずに更新したときはnullptr)
+    // 確保したメモリは次のフレームの始めにまとめて解放されるので、個別に解放しなくて良い
+    std::pmr::memory_resource* pScratch = nullptr;
+};
+
+
+// コンポーネントの処理(OnStart/OnPreUpdate/OnUpdate/OnPostUpdate)に渡される情報
+// 持ち主を参照で持つため、GetOwner().lock() のアトミック操作無しで持ち主を使える
+// 処理の呼び出しの間だけ有効なので、保持しないこと
+class UpdateContext
+{
+public:
+    UpdateContext(GameObject& a_owner,const FrameContext& a_frame)
+        : m_pOwner(&a_owner)
+        , m_pFrame(&a_frame)
+    {
+    }
+
+    // 処理を呼ばれているコンポーネントの持ち主
+    GameObject& GetOwner() const
+    {
+        return *m_pOwner;
+    }
+
+    // 前のフレームからの経過時間(秒)
+    float GetDeltaTime() const
+    {
+        return m_pFrame->deltaTime;
+    }
+
+    // UpdateWorld を呼んだ回数 (最初のフレームが0)
+    std::uint64_t GetFrameIndex() const
+    {
+        return m_pFrame->frameIndex;
+    }
+
+    // 更新しているワールド (ObjectManagerを通さずに更新したときはnullptr)
+    ObjectManager* GetWorld() const
+    {
+        return m_pFrame->pWorld;
+    }
+
+    // フレームの間だけ使う一時的なメモリの確保先 (std::pmr のコンテナに渡して使う)
+    // 複数のスレッドから同時に確保して良い。ObjectManagerを通さずに更新したときはnullptr
+    std::pmr::memory_resource* GetScratch() const
+    {
+        return m_pFrame->pScratch;
+    }
+
+    const FrameContext& GetFrame() const
+    {
+        return *m_pFrame;
+    }
+
+private:
+    GameObject* m_pOwner;
+    const FrameContext* m_pFrame;
+};
+
+#endif // UPDATE_CONTEXT_HPP
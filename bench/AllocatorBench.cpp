@@ -0,0 +1,84 @@
+﻿#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <memory_resource>
+
+#include "ObjectManager.hpp"
+#include "SampleComponents.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// ObjectManager に渡すメモリリソースを変えて、作成・更新・全解放にかかる時間と、グローバルな new の回数を比べる
+// 使い方: AllocatorBench [オブジェクト数=50000]
+// 確かめること (user-019): オブジェクト・コンポーネント・名前を渡したメモリリソースから確保し、グローバルな new がほぼ呼ばれない
+// 参考 (1コア・Release・既定の引数): new_delete_resource 15万回 370 ms、unsynchronized_pool_resource 210回 337 ms、
+// monotonic_buffer_resource 210回 335 ms (残りの210回は pmr を使わない配列 (スロットマップ・コンポーネントのプールなど) の拡張)
+
+// グローバルな new の回数を数える (このベンチマークの実行ファイルだけで置き換える)
+static std::size_t g_allocationCount = 0;
+
+void* operator new(std::size_t a_size)
+{
+    ++g_allocationCount;
+    if(void* p = std::malloc(a_size != 0 ? a_size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* a_p) noexcept
+{
+    std::free(a_p);
+}
+
+void operator delete(void* a_p,std::size_t) noexcept
+{
+    std::free(a_p);
+}
+
+namespace
+{
+    // 引数のメモリリソースを使う ObjectManager で、オブジェクトを作成・1回更新・全て解放する
+    void Run(const char* a_pLabel,std::pmr::memory_resource* a_pMemoryResource,std::size_t a_objectCount)
+    {
+        std::size_t allocationBegin = g_allocationCount;
+        double ms = 0.0;
+        {
+            ScopedMuteCout mute;
+            ms = MeasureMilliseconds([&]()
+                {
+                    ObjectManager objectManager(DataStorageType::Archetype,a_pMemoryResource);
+                    for(std::size_t i = 0; i < a_objectCount; ++i)
+                    {
+                        SharedPtr<GameObject> spObj = objectManager.GenerateObject("EnemyWithALongName");
+                        spObj->AddComponent<TransformComponent>(1.0f,2.0f);
+                        spObj->AddComponent<RendererComponent>();
+                    }
+                    objectManager.UpdateWorld(0.016f);
+                    objectManager.ReleaseAllObjects();
+                });
+        }
+        std::cout << a_pLabel << ": " << ms << " ms, global new " << (g_allocationCount - allocationBegin) << " times" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,50000);
+
+    std::cout << "objects: " << objectCount << " (spawn + UpdateWorld + ReleaseAllObjects)" << std::endl;
+
+    Run("new_delete_resource",std::pmr::new_delete_resource(),objectCount);
+    {
+        std::pmr::unsynchronized_pool_resource poolResource;
+        Run("unsynchronized_pool_resource",&poolResource,objectCount);
+    }
+    {
+        // ReleaseAllObjects の後にまとめて解放する
+        std::pmr::monotonic_buffer_resource arena(64 << 20);
+        Run("monotonic_buffer_resource",&arena,objectCount);
+    }
+    return 0;
+}
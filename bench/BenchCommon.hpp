@@ -0,0 +1,57 @@
+﻿#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstddef>
+
+
+
+// ベンチマークで共通に使う道具
+// 計測はビルドの最適化に左右されるので、-DCMAKE_BUILD_TYPE=Release でビルドして実行すること
+
+// 生きている間 std::cout への出力を捨てる (サンプルのコンポーネントが OnStart などで表示するため)
+class ScopedMuteCout
+{
+public:
+    ScopedMuteCout()
+        : m_pPrevBuf(std::cout.rdbuf(m_sink.rdbuf()))
+    {
+    }
+
+    ~ScopedMuteCout()
+    {
+        std::cout.rdbuf(m_pPrevBuf);
+    }
+
+    ScopedMuteCout(const ScopedMuteCout&) = delete;
+    ScopedMuteCout& operator=(const ScopedMuteCout&) = delete;
+
+private:
+    std::ostringstream m_sink;
+    std::streambuf* m_pPrevBuf;
+};
+
+// 引数の関数を1回呼んだ時間をミリ秒で返す
+template<typename Func>
+double MeasureMilliseconds(Func&& a_func)
+{
+    auto begin = std::chrono::steady_clock::now();
+    a_func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::milli>(end - begin).count();
+}
+
+// コマンドライン引数の a_index 番目を数値として返す (無ければ a_default)
+inline std::size_t GetArgOr(int a_argc,char** a_argv,int a_index,std::size_t a_default)
+{
+    if(a_index < a_argc)
+    {
+        return static_cast<std::size_t>(std::strtoull(a_argv[a_index],nullptr,10));
+    }
+    return a_default;
+}
+
+#endif // BENCH_COMMON_HPP
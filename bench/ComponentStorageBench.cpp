@@ -0,0 +1,176 @@
+﻿#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <typeinfo>
+
+#include "Component.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// GameObject のコンポーネントの持ち方 (型IDの昇順に並べた配列) と、
+// 以前の持ち方 (型名の文字列をキーにした unordered_map) の、1オブジェクトあたりのメモリ・更新・型からの取得を比べる
+// 使い方: ComponentStorageBench [オブジェクト数=100000] [フレーム数=50]
+// 確かめること (user-002): 1オブジェクトあたりのメモリと、1フレームの更新の時間が以前の持ち方より小さい
+// 参考 (1コア・Release・既定の引数): 以前 676 バイト・13回確保・更新 11.0 ms → 224 バイト・4回確保・更新 6.3 ms
+
+// 確保した量と回数を数える (このベンチマークの実行ファイルだけで置き換える)
+static std::size_t g_allocatedBytes = 0;
+static std::size_t g_allocationCount = 0;
+
+void* operator new(std::size_t a_size)
+{
+    g_allocatedBytes += a_size;
+    ++g_allocationCount;
+    if(void* p = std::malloc(a_size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* a_p) noexcept
+{
+    std::free(a_p);
+}
+
+void operator delete(void* a_p,std::size_t) noexcept
+{
+    std::free(a_p);
+}
+
+namespace
+{
+    struct CompA : ComponentBase { float value = 0.0f; void OnUpdate() override { value += 1.0f; } };
+    struct CompB : ComponentBase { float value = 0.0f; void OnUpdate() override { value += 2.0f; } };
+    struct CompC : ComponentBase { float value = 0.0f; void OnUpdate() override { value += 3.0f; } };
+    struct CompD : ComponentBase { float value = 0.0f; void OnUpdate() override { value += 4.0f; } };
+
+    // 以前の GameObject のコンポーネントの持ち方を再現したもの (比較用)
+    struct MapStorageObject
+    {
+        std::unordered_map<std::string,SharedPtr<ComponentBase>> umNameToComp;
+
+        template<typename CompType>
+        void AddComponent()
+        {
+            umNameToComp[typeid(CompType).name()] = MakeShared<CompType>();
+        }
+
+        template<typename CompType>
+        WeakPtr<CompType> GetComponent()
+        {
+            auto itr = umNameToComp.find(typeid(CompType).name());
+            if(itr == umNameToComp.end())
+            {
+                return WeakPtr<CompType>();
+            }
+            return WeakPtr<CompType>(StaticPointerCast<CompType>(itr->second));
+        }
+
+        void Update()
+        {
+            for(auto& pair : umNameToComp)
+            {
+                pair.second->OnUpdate();
+            }
+        }
+    };
+
+    struct Result
+    {
+        double bytesPerObject;
+        double allocationsPerObject;
+        double updateMs;
+        double getComponentMs;
+    };
+
+    template<typename ObjectType,typename CreateFunc,typename UpdateFunc>
+    Result Measure(std::size_t a_objectCount,std::size_t a_frameCount,CreateFunc a_create,UpdateFunc a_update)
+    {
+        std::vector<SharedPtr<ObjectType>> vObjects;
+        vObjects.reserve(a_objectCount);
+        for(std::size_t i = 0; i < a_objectCount; ++i)
+        {
+            vObjects.push_back(a_create());
+        }
+
+        Result result{};
+        std::size_t bytesBegin = g_allocatedBytes;
+        std::size_t countBegin = g_allocationCount;
+        for(SharedPtr<ObjectType>& spObj : vObjects)
+        {
+            spObj->template AddComponent<CompA>();
+            spObj->template AddComponent<CompB>();
+            spObj->template AddComponent<CompC>();
+            spObj->template AddComponent<CompD>();
+        }
+        result.bytesPerObject = static_cast<double>(g_allocatedBytes - bytesBegin) / static_cast<double>(a_objectCount);
+        result.allocationsPerObject = static_cast<double>(g_allocationCount - countBegin) / static_cast<double>(a_objectCount);
+
+        result.updateMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < a_frameCount; ++f)
+                {
+                    for(SharedPtr<ObjectType>& spObj : vObjects)
+                    {
+                        a_update(*spObj);
+                    }
+                }
+            }) / static_cast<double>(a_frameCount);
+
+        std::size_t hitCount = 0;
+        result.getComponentMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < a_frameCount; ++f)
+                {
+                    for(SharedPtr<ObjectType>& spObj : vObjects)
+                    {
+                        hitCount += spObj->template GetComponent<CompC>().expired() ? 0 : 1;
+                    }
+                }
+            }) / static_cast<double>(a_frameCount);
+        if(hitCount != a_objectCount * a_frameCount)
+        {
+            std::cout << "unexpected GetComponent result" << std::endl;
+        }
+        return result;
+    }
+
+    void Print(const char* a_pLabel,const Result& a_result)
+    {
+        std::cout << a_pLabel << ": " << a_result.bytesPerObject << " bytes/object, "
+            << a_result.allocationsPerObject << " allocations/object, Update " << a_result.updateMs << " ms/frame, GetComponent<T> "
+            << a_result.getComponentMs << " ms/frame" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,100000);
+    std::size_t frameCount = GetArgOr(argc,argv,2,50);
+
+    std::cout << "objects: " << objectCount << " x 4 components, frames: " << frameCount << std::endl;
+
+    Result mapResult = Measure<MapStorageObject>(objectCount,frameCount,
+        []() { return MakeShared<MapStorageObject>(); },
+        [](MapStorageObject& a_obj) { a_obj.Update(); });
+    Print("unordered_map<string>",mapResult);
+
+    Result flatResult;
+    {
+        ScopedMuteCout mute;
+        flatResult = Measure<GameObject>(objectCount,frameCount,
+            []()
+            {
+                SharedPtr<GameObject> spObj = MakeShared<GameObject>();
+                spObj->SetActive(true);
+                return spObj;
+            },
+            [](GameObject& a_obj) { a_obj.Update(); });
+    }
+    Print("GameObject (sorted array)",flatResult);
+    return 0;
+}
@@ -0,0 +1,206 @@
+﻿#include <vector>
+
+#include "ObjectManager.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 処理をオーバーライドしているコンポーネントだけを呼ぶ場合と、全てのコンポーネントの全ての処理を仮想関数で呼ぶ場合を比べる
+// 1オブジェクトに8個のコンポーネントを持たせ、OnUpdate を実装するのは1個だけ (OnPreUpdate/OnPostUpdate は誰も実装しない)
+// また、引数無しの OnUpdate() だけをオーバーライドした型を型ごとのプールから呼ぶときの、仮想関数を2回経由する分の費用を計る
+// 使い方: HookDispatchBench [オブジェクト数=50000] [フレーム数=50]
+// 確かめること (user-006): 処理を実装していないコンポーネントの呼び出しが無くなり、全てを呼ぶ場合より速い
+// 参考 (1コア・Release・既定の引数): 全て仮想関数 5.0 ms、オブジェクトごとの処理の配列 2.5 ms、型ごとのプール 0.35 ms
+
+namespace
+{
+    // どの更新処理もオーバーライドしないコンポーネント
+    template<int N>
+    struct IdleComponent : ComponentBase
+    {
+        int value = 0;
+    };
+
+    // OnUpdate だけをオーバーライドするコンポーネント
+    struct CounterComponent : ComponentBase
+    {
+        int value = 0;
+        void OnUpdate(const UpdateContext&) override { ++value; }
+    };
+
+    // 引数無しの OnUpdate だけをオーバーライドするコンポーネント
+    // UpdateContext を受け取る版が隠れるため、プールからは ComponentBase::OnUpdate(ctx) を経由して呼ばれる
+    struct LegacyCounterComponent : ComponentBase
+    {
+        int value = 0;
+        void OnUpdate() override { ++value; }
+    };
+
+    // 1種類のコンポーネントを1つずつ持つオブジェクトを作り、UpdateWorld 1回あたりの時間を返す
+    template<typename CompType>
+    double MeasureSinglePool(std::size_t a_objectCount,std::size_t a_frameCount)
+    {
+        ObjectManager objectManager;
+        for(std::size_t i = 0; i < a_objectCount; ++i)
+        {
+            objectManager.Resolve(objectManager.SpawnObject())->AddComponent<CompType>();
+        }
+        objectManager.UpdateWorld(0.016f);
+        double ms = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < a_frameCount; ++f)
+                {
+                    objectManager.UpdateWorld(0.016f);
+                }
+            }) / static_cast<double>(a_frameCount);
+        objectManager.ReleaseAllObjects();
+        return ms;
+    }
+
+    // 以前の更新で呼んでいた、オブジェクトの全てのコンポーネント
+    void CollectComponents(GameObject& a_obj,std::vector<ComponentBase*>& a_vComps)
+    {
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<0>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<1>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<2>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<3>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<4>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<5>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<IdleComponent<6>>().lock().get());
+        a_vComps.push_back(a_obj.GetComponent<CounterComponent>().lock().get());
+    }
+
+    void AddComponents(GameObject& a_obj)
+    {
+        a_obj.AddComponent<IdleComponent<0>>();
+        a_obj.AddComponent<IdleComponent<1>>();
+        a_obj.AddComponent<IdleComponent<2>>();
+        a_obj.AddComponent<IdleComponent<3>>();
+        a_obj.AddComponent<IdleComponent<4>>();
+        a_obj.AddComponent<IdleComponent<5>>();
+        a_obj.AddComponent<IdleComponent<6>>();
+        a_obj.AddComponent<CounterComponent>();
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,50000);
+    std::size_t frameCount = GetArgOr(argc,argv,2,50);
+    constexpr std::size_t COMPONENT_COUNT = 8;
+
+    std::cout << "objects: " << objectCount << " x " << COMPONENT_COUNT << " components (1 implements OnUpdate), frames: " << frameCount << std::endl;
+
+    double allMs = 0.0;
+    double hookListMs = 0.0;
+    double poolMs = 0.0;
+    {
+        ScopedMuteCout mute;
+        std::vector<SharedPtr<GameObject>> vObjects;
+        std::vector<ComponentBase*> vAllComps;
+        vObjects.reserve(objectCount);
+        vAllComps.reserve(objectCount * COMPONENT_COUNT);
+        for(std::size_t i = 0; i < objectCount; ++i)
+        {
+            SharedPtr<GameObject> spObj = MakeShared<GameObject>();
+            spObj->SetActive(true);
+            AddComponents(*spObj);
+            CollectComponents(*spObj,vAllComps);
+            spObj->PreUpdate(); // OnStart を済ませておく
+            vObjects.push_back(spObj);
+        }
+
+        // 以前の更新: 全てのコンポーネントの全ての処理を仮想関数で呼ぶ
+        FrameContext frame;
+        allMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < frameCount; ++f)
+                {
+                    std::size_t compBegin = 0;
+                    for(SharedPtr<GameObject>& spObj : vObjects)
+                    {
+                        UpdateContext ctx(*spObj,frame);
+                        for(std::size_t c = 0; c < COMPONENT_COUNT; ++c) vAllComps[compBegin + c]->OnPreUpdate(ctx);
+                        for(std::size_t c = 0; c < COMPONENT_COUNT; ++c) vAllComps[compBegin + c]->OnUpdate(ctx);
+                        for(std::size_t c = 0; c < COMPONENT_COUNT; ++c) vAllComps[compBegin + c]->OnPostUpdate(ctx);
+                        compBegin += COMPONENT_COUNT;
+                    }
+                }
+            }) / static_cast<double>(frameCount);
+
+        // オブジェクトごとの更新: 処理ごとに、その処理を実装しているコンポーネントだけを呼ぶ
+        hookListMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < frameCount; ++f)
+                {
+                    for(SharedPtr<GameObject>& spObj : vObjects)
+                    {
+                        spObj->PreUpdate(frame);
+                        spObj->Update(frame);
+                        spObj->PostUpdate(frame);
+                    }
+                }
+            }) / static_cast<double>(frameCount);
+
+        // ObjectManager の更新: 処理を実装している型のプールだけを辿る
+        ObjectManager objectManager;
+        for(std::size_t i = 0; i < objectCount; ++i)
+        {
+            AddComponents(*objectManager.Resolve(objectManager.SpawnObject()));
+        }
+        objectManager.UpdateWorld(0.016f);
+        poolMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < frameCount; ++f)
+                {
+                    objectManager.UpdateWorld(0.016f);
+                }
+            }) / static_cast<double>(frameCount);
+        objectManager.ReleaseAllObjects();
+    }
+
+    // 引数無しの版だけをオーバーライドした型の費用
+    // プールの更新の差と、同じインスタンスを直接呼んだ場合 (CompType::OnUpdate()) と仮想関数で呼んだ場合の差を見る
+    double contextPoolMs = 0.0;
+    double legacyPoolMs = 0.0;
+    double legacyDirectNs = 0.0;
+    double legacyVirtualNs = 0.0;
+    {
+        ScopedMuteCout mute;
+        contextPoolMs = MeasureSinglePool<CounterComponent>(objectCount,frameCount);
+        legacyPoolMs = MeasureSinglePool<LegacyCounterComponent>(objectCount,frameCount);
+
+        std::vector<SharedPtr<LegacyCounterComponent>> vComps;
+        vComps.reserve(objectCount);
+        for(std::size_t i = 0; i < objectCount; ++i)
+        {
+            vComps.push_back(MakeShared<LegacyCounterComponent>());
+        }
+        GameObject owner;
+        FrameContext frame;
+        UpdateContext ctx(owner,frame);
+        double callCount = static_cast<double>(objectCount * frameCount);
+        legacyDirectNs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < frameCount; ++f)
+                {
+                    for(SharedPtr<LegacyCounterComponent>& spComp : vComps) spComp->LegacyCounterComponent::OnUpdate();
+                }
+            }) * 1.0e6 / callCount;
+        legacyVirtualNs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t f = 0; f < frameCount; ++f)
+                {
+                    for(SharedPtr<LegacyCounterComponent>& spComp : vComps) static_cast<ComponentBase&>(*spComp).OnUpdate(ctx);
+                }
+            }) * 1.0e6 / callCount;
+    }
+
+    std::cout << "all hooks (virtual): " << allMs << " ms/frame" << std::endl;
+    std::cout << "per-object hook lists: " << hookListMs << " ms/frame" << std::endl;
+    std::cout << "ObjectManager::UpdateWorld (per-type pools): " << poolMs << " ms/frame" << std::endl;
+    std::cout << "single pool, OnUpdate(const UpdateContext&) override: " << contextPoolMs << " ms/frame" << std::endl;
+    std::cout << "single pool, OnUpdate() override only: " << legacyPoolMs << " ms/frame" << std::endl;
+    std::cout << "OnUpdate() override only, per call: direct " << legacyDirectNs << " ns, through OnUpdate(ctx) " << legacyVirtualNs << " ns" << std::endl;
+    return 0;
+}
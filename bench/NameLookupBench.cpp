@@ -0,0 +1,169 @@
+﻿#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectManager.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 名前からオブジェクト/コンポーネントを探す時間と、1回あたりの確保回数を比べる
+// 以前の方法 (string_view から一時的な std::string を作って unordered_map を引く) と、
+// FindObject(std::string_view)、InternName で取得した NameKey を渡す FindObject、GetComponent(std::string_view) を計測する
+// 使い方: NameLookupBench [オブジェクト数=10000] [検索回数=1000000]
+
+// 確保した回数を数える (このベンチマークの実行ファイルだけで置き換える)
+static std::size_t g_allocationCount = 0;
+
+void* operator new(std::size_t a_size)
+{
+    ++g_allocationCount;
+    if(void* p = std::malloc(a_size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* a_p) noexcept
+{
+    std::free(a_p);
+}
+
+void operator delete(void* a_p,std::size_t) noexcept
+{
+    std::free(a_p);
+}
+
+namespace
+{
+    struct HealthComponentForLookup : ComponentBase {};
+    struct ArmorComponentForLookup : ComponentBase {};
+
+    // 1回あたりの時間(ナノ秒)と確保回数
+    struct Result
+    {
+        double nsPerLookup;
+        double allocationsPerLookup;
+    };
+
+    // a_lookup(i) を a_count 回呼んだ結果を返す (見つかった数を a_rFound に足す)
+    template<typename LookupFunc>
+    Result Measure(std::size_t a_count,std::size_t& a_rFound,LookupFunc a_lookup)
+    {
+        std::size_t countBegin = g_allocationCount;
+        double ms = MeasureMilliseconds([&]()
+            {
+                for(std::size_t i = 0; i < a_count; ++i)
+                {
+                    a_rFound += a_lookup(i) ? 1 : 0;
+                }
+            });
+        Result result;
+        result.nsPerLookup = ms * 1.0e6 / static_cast<double>(a_count);
+        result.allocationsPerLookup = static_cast<double>(g_allocationCount - countBegin) / static_cast<double>(a_count);
+        return result;
+    }
+
+    void Print(const char* a_label,const Result& a_result)
+    {
+        std::cout << "  " << a_label << ": " << a_result.nsPerLookup << " ns, "
+            << a_result.allocationsPerLookup << " allocs per lookup" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,10000);
+    std::size_t lookupCount = GetArgOr(argc,argv,2,1000000);
+    std::size_t found = 0;
+
+    Result oldObject{};
+    Result viewObject{};
+    Result keyObject{};
+    Result oldComponent{};
+    Result viewComponent{};
+    {
+        ScopedMuteCout mute;
+        ObjectManager objectManager;
+
+        // 短い文字列の最適化に収まらない長さの名前にする (以前の方法では一時的な文字列が確保される)
+        const std::string baseName = "EnemySpawnPointObject";
+        std::vector<std::string> vNames;
+        vNames.reserve(objectCount);
+        for(std::size_t i = 0; i < objectCount; ++i)
+        {
+            ObjectHandle handle = objectManager.CreateObject(baseName);
+            vNames.emplace_back(objectManager.Resolve(handle)->GetName());
+        }
+
+        // 以前の ObjectManager の名前の表を再現したもの (比較用)
+        std::unordered_map<std::string,ObjectHandle> umOldNameToObj;
+        for(const std::string& name : vNames)
+        {
+            umOldNameToObj.emplace(name,objectManager.FindObject(name));
+        }
+
+        std::vector<std::string_view> vViews(vNames.begin(),vNames.end());
+        std::vector<NameKey> vKeys;
+        vKeys.reserve(objectCount);
+        for(std::string_view name : vViews)
+        {
+            vKeys.push_back(objectManager.InternName(name));
+        }
+
+        oldObject = Measure(lookupCount,found,[&](std::size_t i)
+            {
+                std::string_view name = vViews[i % objectCount];
+                return umOldNameToObj.find(std::string(name.data(),name.size())) != umOldNameToObj.end();
+            });
+        viewObject = Measure(lookupCount,found,[&](std::size_t i)
+            {
+                return !objectManager.FindObject(vViews[i % objectCount]).IsNull();
+            });
+        keyObject = Measure(lookupCount,found,[&](std::size_t i)
+            {
+                return !objectManager.FindObject(vKeys[i % objectCount]).IsNull();
+            });
+
+        // コンポーネントは1つのオブジェクトに名前付きで追加して、名前から取得する
+        SharedPtr<GameObject> spOwner = objectManager.GenerateObject("ComponentOwner");
+        const std::string healthName = "HealthComponentForLookup";
+        const std::string armorName = "ArmorComponentForLookup";
+        spOwner->AddComponent(MakeShared<HealthComponentForLookup>(),healthName);
+        spOwner->AddComponent(MakeShared<ArmorComponentForLookup>(),armorName);
+        const std::string_view compNames[] = { healthName,armorName };
+
+        std::unordered_map<std::string,ComponentBase*> umOldNameToComp;
+        umOldNameToComp.emplace(healthName,spOwner->GetComponent(healthName).lock().get());
+        umOldNameToComp.emplace(armorName,spOwner->GetComponent(armorName).lock().get());
+
+        oldComponent = Measure(lookupCount,found,[&](std::size_t i)
+            {
+                std::string_view name = compNames[i & 1];
+                return umOldNameToComp.find(std::string(name.data(),name.size())) != umOldNameToComp.end();
+            });
+        viewComponent = Measure(lookupCount,found,[&](std::size_t i)
+            {
+                return !spOwner->GetComponent(compNames[i & 1]).expired();
+            });
+
+        spOwner.reset();
+        vKeys.clear();
+        objectManager.ReleaseAllObjects();
+    }
+
+    std::cout << objectCount << " objects, " << lookupCount << " lookups (found " << found << ")" << std::endl;
+    std::cout << "object by name:" << std::endl;
+    Print("std::string key (before)",oldObject);
+    Print("FindObject(std::string_view)",viewObject);
+    Print("FindObject(NameKey)",keyObject);
+    std::cout << "component by name:" << std::endl;
+    Print("std::string key (before)",oldComponent);
+    Print("GetComponent(std::string_view)",viewComponent);
+    return 0;
+}
@@ -0,0 +1,119 @@
+﻿#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectManager.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 同じ名前のオブジェクトを大量に作成したときの、番号付きの名前を決める時間を比べる
+// 以前の方法 (name1, name2, ... を文字列にして空きを探す) は作成数の2乗、現在の方法 (名前ごとの番号と空いた番号) は作成数に比例する
+// 番号付きの名前が先に直接登録されている場合も、作成数に比例することを確かめる
+// 使い方: NameSuffixBench [最大作成数=100000]
+// 確かめること (user-012): 作成数を10倍にしたときに、時間もおよそ10倍にしかならない (以前の方法は100倍)
+// 参考 (1コア・Release): 1万個で以前 5.0 秒 → 7.6 ms、10万個 140 ms、"Bullet1"～"Bullet100000" が登録済みでも 234 ms
+
+namespace
+{
+    // 以前の ObjectManager::CreateObjName を再現したもの (比較用)
+    class ProbingNameTable
+    {
+    public:
+        std::string Create(const std::string& a_baseName)
+        {
+            std::string name = a_baseName;
+            for(std::size_t suffix = 1; m_umNameToObj.count(name) != 0; ++suffix)
+            {
+                name = a_baseName + std::to_string(suffix);
+            }
+            m_umNameToObj.emplace(name,nullptr);
+            return name;
+        }
+
+    private:
+        std::unordered_map<std::string,void*> m_umNameToObj;
+    };
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t maxCount = GetArgOr(argc,argv,1,100000);
+
+    for(std::size_t count = 1000; count <= maxCount; count *= 10)
+    {
+        // 以前の方法は2乗で遅くなるので、1万個までにする
+        double probingMs = -1.0;
+        if(count <= 10000)
+        {
+            ProbingNameTable probingTable;
+            probingMs = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t i = 0; i < count; ++i)
+                    {
+                        probingTable.Create("Bullet");
+                    }
+                });
+        }
+
+        double createMs = 0.0;
+        double churnMs = 0.0;
+        {
+            ScopedMuteCout mute;
+            ObjectManager objectManager;
+            std::vector<ObjectHandle> vHandles;
+            vHandles.reserve(count);
+            createMs = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t i = 0; i < count; ++i)
+                    {
+                        vHandles.push_back(objectManager.CreateObject("Bullet"));
+                    }
+                });
+
+            // 半分を削除してから同じ数を作り直す (空いた番号が再利用される)
+            for(std::size_t i = 0; i < count; i += 2)
+            {
+                objectManager.Resolve(vHandles[i])->SetActive(false);
+            }
+            objectManager.UpdateWorld(0.016f);
+            churnMs = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t i = 0; i < count; i += 2)
+                    {
+                        objectManager.CreateObject("Bullet");
+                    }
+                });
+            objectManager.ReleaseAllObjects();
+        }
+
+        // "Bullet1" ～ "BulletN" が直接指定で登録済みのところに、同じ数の "Bullet" を作る
+        // 重なった番号は最初の1回だけ調べて捨てるので、作成数に比例する時間で済む
+        double preExistingMs = 0.0;
+        {
+            ScopedMuteCout mute;
+            ObjectManager objectManager;
+            for(std::size_t i = 1; i <= count; ++i)
+            {
+                objectManager.CreateObject("Bullet" + std::to_string(i));
+            }
+            preExistingMs = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t i = 0; i < count; ++i)
+                    {
+                        objectManager.CreateObject("Bullet");
+                    }
+                });
+            objectManager.ReleaseAllObjects();
+        }
+
+        std::cout << count << " x \"Bullet\": create " << createMs << " ms, recreate half " << churnMs << " ms"
+            << ", with Bullet1..Bullet" << count << " existing " << preExistingMs << " ms";
+        if(probingMs >= 0.0)
+        {
+            std::cout << ", probing (before) " << probingMs << " ms";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
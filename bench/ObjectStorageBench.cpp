@@ -0,0 +1,162 @@
+﻿#include <list>
+#include <vector>
+
+#include "Component.hpp"
+#include "SlotMap.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// ObjectManager のオブジェクトの持ち方 (SlotMap) と、以前の持ち方 (std::list と、名前の表が持つリストの反復子) で、
+// 作成・全体の走査・削除・作り直しの時間を比べる
+// 使い方: ObjectStorageBench [オブジェクト数=1000000] [走査の回数=20]
+
+namespace
+{
+    // 以前の ObjectManager のオブジェクトの持ち方を再現したもの (比較用)
+    // 削除するオブジェクトはリストの反復子で指定する
+    struct ListStorage
+    {
+        using Handle = std::list<SharedPtr<GameObject>>::iterator;
+
+        std::list<SharedPtr<GameObject>> lObjects;
+
+        Handle Insert(SharedPtr<GameObject> a_spObj)
+        {
+            lObjects.push_back(std::move(a_spObj));
+            return std::prev(lObjects.end());
+        }
+
+        void Erase(Handle a_handle)
+        {
+            lObjects.erase(a_handle);
+        }
+
+        template<typename Func>
+        void ForEach(Func&& a_func)
+        {
+            for(SharedPtr<GameObject>& spObj : lObjects)
+            {
+                a_func(*spObj);
+            }
+        }
+    };
+
+    // 現在の持ち方
+    struct SlotMapStorage
+    {
+        using Handle = ObjectHandle;
+
+        SlotMap<SharedPtr<GameObject>> slotMapObjects;
+
+        Handle Insert(SharedPtr<GameObject> a_spObj)
+        {
+            return slotMapObjects.Insert(std::move(a_spObj));
+        }
+
+        void Erase(Handle a_handle)
+        {
+            slotMapObjects.Erase(a_handle);
+        }
+
+        template<typename Func>
+        void ForEach(Func&& a_func)
+        {
+            for(SharedPtr<GameObject>& spObj : slotMapObjects.GetDense())
+            {
+                a_func(*spObj);
+            }
+        }
+    };
+
+    struct Result
+    {
+        double spawnMs;
+        double iterateMs; // 1回あたり
+        double despawnMs;
+        double respawnMs;
+        std::size_t activeCount;
+    };
+
+    template<typename Storage>
+    Result Measure(std::size_t a_objectCount,std::size_t a_passCount)
+    {
+        ScopedMuteCout mute;
+
+        // オブジェクトは先に作っておき、ここでも保持する
+        // (作成と破棄の時間を含めず、持ち方による差だけを計測する。GameObject のデストラクタは表示も行うため)
+        std::vector<SharedPtr<GameObject>> vObjects;
+        vObjects.reserve(a_objectCount + a_objectCount / 2 + 1);
+        for(std::size_t i = 0; i < a_objectCount + (a_objectCount + 1) / 2; ++i)
+        {
+            vObjects.push_back(MakeShared<GameObject>());
+            vObjects.back()->SetActive(true);
+        }
+
+        Storage storage;
+        std::vector<typename Storage::Handle> vHandles;
+        vHandles.reserve(a_objectCount);
+
+        Result result{};
+        result.spawnMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t i = 0; i < a_objectCount; ++i)
+                {
+                    vHandles.push_back(storage.Insert(vObjects[i]));
+                }
+            });
+
+        // 最適化で消されないよう、有効なオブジェクトを数えて表示する
+        std::size_t activeCount = 0;
+        result.iterateMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t p = 0; p < a_passCount; ++p)
+                {
+                    storage.ForEach([&](GameObject& a_obj)
+                        {
+                            activeCount += a_obj.IsActive() ? 1 : 0;
+                        });
+                }
+            }) / static_cast<double>(a_passCount);
+
+        // 半分を飛び飛びに削除してから、同じ数を作り直す
+        result.despawnMs = MeasureMilliseconds([&]()
+            {
+                for(std::size_t i = 0; i < a_objectCount; i += 2)
+                {
+                    storage.Erase(vHandles[i]);
+                }
+            });
+        result.respawnMs = MeasureMilliseconds([&]()
+            {
+                std::size_t next = a_objectCount;
+                for(std::size_t i = 0; i < a_objectCount; i += 2)
+                {
+                    vHandles[i] = storage.Insert(vObjects[next++]);
+                }
+            });
+
+        result.activeCount = activeCount / a_passCount;
+        return result;
+    }
+
+    void Print(const char* a_label,const Result& a_result)
+    {
+        std::cout << a_label << ": spawn " << a_result.spawnMs << " ms, iterate " << a_result.iterateMs
+            << " ms per pass, despawn half " << a_result.despawnMs << " ms, respawn half " << a_result.respawnMs << " ms"
+            << " (" << a_result.activeCount << " active)" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,1000000);
+    std::size_t passCount = GetArgOr(argc,argv,2,20);
+
+    std::cout << objectCount << " objects" << std::endl;
+    Result listResult = Measure<ListStorage>(objectCount,passCount);
+    Result slotMapResult = Measure<SlotMapStorage>(objectCount,passCount);
+    Print("std::list (before)",listResult);
+    Print("SlotMap           ",slotMapResult);
+    return 0;
+}
@@ -0,0 +1,193 @@
+﻿#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "ObjectManager.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 生成と破棄を繰り返す場面で、1フレームあたりに global operator new が呼ばれる回数を、再利用の有無で比べる
+// 1. 毎フレーム、コンポーネントを2つ持つオブジェクトを作成し、前のフレームに作ったものを削除する
+// 2. 毎フレーム、同じオブジェクトからコンポーネントを RemoveComponent で外し、AddComponent で付け直す
+// 確保の回数は、最初の数フレーム(容量が伸びきるまで)を除いた後のフレームで数える
+// 使い方: RecycleBench [1フレームの作成数=1000] [フレーム数=100]
+
+// 確保した回数を数える (このベンチマークの実行ファイルだけで置き換える)
+static std::size_t g_allocationCount = 0;
+
+void* operator new(std::size_t a_size)
+{
+    ++g_allocationCount;
+    if(void* p = std::malloc(a_size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* a_p) noexcept
+{
+    std::free(a_p);
+}
+
+void operator delete(void* a_p,std::size_t) noexcept
+{
+    std::free(a_p);
+}
+
+namespace
+{
+    struct Bullet : ComponentBase
+    {
+        float x = 0.0f;
+        void OnUpdate() override { x += 1.0f; }
+        void OnReset() override { x = 0.0f; }
+    };
+
+    struct Lifetime : ComponentBase
+    {
+        int frames = 0;
+        void OnUpdate() override { ++frames; }
+        void OnReset() override { frames = 0; }
+    };
+
+    // 容量が伸びきるまでのフレーム数 (この間の確保は数えない)
+    constexpr std::size_t WARMUP_FRAMES = 10;
+
+    struct Result
+    {
+        double allocationsPerFrame;
+        double msPerFrame;
+    };
+
+    // 再利用の上限をセットする (0 なら再利用しない)
+    void SetRecycleCapacity(ObjectManager& a_objectManager,std::size_t a_capacity)
+    {
+        a_objectManager.SetObjectRecycleCapacity(a_capacity);
+        a_objectManager.SetComponentRecycleCapacity<Bullet>(a_capacity);
+        a_objectManager.SetComponentRecycleCapacity<Lifetime>(a_capacity);
+    }
+
+    // 1. オブジェクトごと作成と削除を繰り返す
+    Result MeasureObjectChurn(std::size_t a_spawnCount,std::size_t a_frameCount,std::size_t a_capacity)
+    {
+        ScopedMuteCout mute;
+        ObjectManager objectManager;
+        SetRecycleCapacity(objectManager,a_capacity);
+
+        std::vector<ObjectHandle> vPrevious;
+        std::vector<ObjectHandle> vCurrent;
+        vPrevious.reserve(a_spawnCount);
+        vCurrent.reserve(a_spawnCount);
+
+        std::size_t countBegin = 0;
+        double ms = 0.0;
+        for(std::size_t f = 0; f < WARMUP_FRAMES + a_frameCount; ++f)
+        {
+            if(f == WARMUP_FRAMES)
+            {
+                countBegin = g_allocationCount;
+            }
+            double frameMs = MeasureMilliseconds([&]()
+                {
+                    for(ObjectHandle handle : vPrevious)
+                    {
+                        objectManager.Resolve(handle)->SetActive(false);
+                    }
+                    vCurrent.clear();
+                    for(std::size_t i = 0; i < a_spawnCount; ++i)
+                    {
+                        ObjectHandle handle = objectManager.SpawnObject();
+                        GameObject* pObj = objectManager.Resolve(handle);
+                        pObj->AddComponent<Bullet>();
+                        pObj->AddComponent<Lifetime>();
+                        vCurrent.push_back(handle);
+                    }
+                    objectManager.UpdateWorld(0.016f);
+                    std::swap(vPrevious,vCurrent);
+                });
+            if(f >= WARMUP_FRAMES)
+            {
+                ms += frameMs;
+            }
+        }
+        Result result;
+        result.allocationsPerFrame = static_cast<double>(g_allocationCount - countBegin) / static_cast<double>(a_frameCount);
+        result.msPerFrame = ms / static_cast<double>(a_frameCount);
+        objectManager.ReleaseAllObjects();
+        return result;
+    }
+
+    // 2. 同じオブジェクトでコンポーネントの削除と追加を繰り返す
+    Result MeasureComponentChurn(std::size_t a_objectCount,std::size_t a_frameCount,std::size_t a_capacity)
+    {
+        ScopedMuteCout mute;
+        ObjectManager objectManager;
+        SetRecycleCapacity(objectManager,a_capacity);
+
+        std::vector<ObjectHandle> vHandles;
+        vHandles.reserve(a_objectCount);
+        for(std::size_t i = 0; i < a_objectCount; ++i)
+        {
+            ObjectHandle handle = objectManager.SpawnObject();
+            objectManager.Resolve(handle)->AddComponent<Bullet>();
+            vHandles.push_back(handle);
+        }
+
+        std::size_t countBegin = 0;
+        double ms = 0.0;
+        for(std::size_t f = 0; f < WARMUP_FRAMES + a_frameCount; ++f)
+        {
+            if(f == WARMUP_FRAMES)
+            {
+                countBegin = g_allocationCount;
+            }
+            double frameMs = MeasureMilliseconds([&]()
+                {
+                    for(ObjectHandle handle : vHandles)
+                    {
+                        GameObject* pObj = objectManager.Resolve(handle);
+                        pObj->RemoveComponent<Bullet>();
+                        pObj->AddComponent<Bullet>();
+                    }
+                    objectManager.UpdateWorld(0.016f);
+                });
+            if(f >= WARMUP_FRAMES)
+            {
+                ms += frameMs;
+            }
+        }
+        Result result;
+        result.allocationsPerFrame = static_cast<double>(g_allocationCount - countBegin) / static_cast<double>(a_frameCount);
+        result.msPerFrame = ms / static_cast<double>(a_frameCount);
+        objectManager.ReleaseAllObjects();
+        return result;
+    }
+
+    void Print(const char* a_label,const Result& a_result)
+    {
+        std::cout << "  " << a_label << ": " << a_result.allocationsPerFrame << " allocs, " << a_result.msPerFrame << " ms per frame" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t spawnCount = GetArgOr(argc,argv,1,1000);
+    std::size_t frameCount = GetArgOr(argc,argv,2,100);
+
+    Result objectOff = MeasureObjectChurn(spawnCount,frameCount,0);
+    Result objectOn = MeasureObjectChurn(spawnCount,frameCount,spawnCount * 2);
+    Result componentOff = MeasureComponentChurn(spawnCount,frameCount,0);
+    Result componentOn = MeasureComponentChurn(spawnCount,frameCount,spawnCount);
+
+    std::cout << spawnCount << " objects per frame, " << frameCount << " frames after " << WARMUP_FRAMES << " warm-up frames" << std::endl;
+    std::cout << "spawn 2 components + despawn:" << std::endl;
+    Print("recycle off",objectOff);
+    Print("recycle on ",objectOn);
+    std::cout << "RemoveComponent + AddComponent:" << std::endl;
+    Print("recycle off",componentOff);
+    Print("recycle on ",componentOn);
+    return 0;
+}
@@ -0,0 +1,111 @@
+﻿#include <vector>
+
+#include "ObjectManager.hpp"
+#include "SampleComponents.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 参照カウントの操作 (lock()・コピー) が多い処理の1回あたりの時間を計る
+// 同じソースを RefCountBench (std::shared_ptr) と RefCountBenchNonAtomic (GAMEOBJECT_NONATOMIC_REFCOUNT=1) の
+// 2つにビルドするので、両方を実行して比べる
+// 使い方: RefCountBench [オブジェクト数=10000] [繰り返し数=200]
+// 確かめること (user-020): 参照カウントをアトミック操作しない版の方が、どの操作も速い
+// 参考 (1コア・Release・既定の引数): GetOwner().lock() 47 → 15 ns、GetComponent<T>().lock() 33 → 20 ns、
+// WeakPtr のコピー 3.4 → 2.1 ns、SharedPtr のコピー 9.4 → 3.0 ns
+
+namespace
+{
+    struct ProbeComponent : ComponentBase
+    {
+        int hitCount = 0;
+    };
+
+    // 引数の関数を a_repeatCount 回呼び、1要素あたりの時間をナノ秒で表示する
+    template<typename Func>
+    void Report(const char* a_pLabel,std::size_t a_elementCount,std::size_t a_repeatCount,Func a_func)
+    {
+        long sum = 0;
+        double ms = MeasureMilliseconds([&]()
+            {
+                for(std::size_t r = 0; r < a_repeatCount; ++r)
+                {
+                    sum += a_func();
+                }
+            });
+        double ns = ms * 1000000.0 / static_cast<double>(a_elementCount * a_repeatCount);
+        // 計算結果も表示し、ループが最適化で消えないようにする
+        std::cout << "  " << a_pLabel << ": " << ns << " ns/op (sum " << sum << ")" << std::endl;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,10000);
+    std::size_t repeatCount = GetArgOr(argc,argv,2,200);
+
+    std::cout << (GAMEOBJECT_NONATOMIC_REFCOUNT ? "non-atomic (LocalSharedPtr)" : "atomic (std::shared_ptr)")
+        << ", objects: " << objectCount << ", repeats: " << repeatCount << std::endl;
+
+    ObjectManager objectManager;
+    std::vector<SharedPtr<GameObject>> vObjects;
+    std::vector<WeakPtr<ProbeComponent>> vProbes;
+    {
+        ScopedMuteCout mute;
+        vObjects.reserve(objectCount);
+        vProbes.reserve(objectCount);
+        for(std::size_t i = 0; i < objectCount; ++i)
+        {
+            SharedPtr<GameObject> spObj = objectManager.GenerateObject("Object");
+            vProbes.push_back(spObj->AddComponent<ProbeComponent>());
+            spObj->AddComponent<TransformComponent>();
+            vObjects.push_back(spObj);
+        }
+        objectManager.UpdateWorld(0.016f);
+    }
+
+    Report("GetOwner().lock()",objectCount,repeatCount,[&]()
+        {
+            long sum = 0;
+            for(WeakPtr<ProbeComponent>& wpProbe : vProbes)
+            {
+                if(SharedPtr<GameObject> spOwner = wpProbe.lock()->GetOwner().lock()) sum += spOwner->IsActive();
+            }
+            return sum;
+        });
+    Report("GetComponent<T>().lock()",objectCount,repeatCount,[&]()
+        {
+            long sum = 0;
+            for(SharedPtr<GameObject>& spObj : vObjects)
+            {
+                if(SharedPtr<ProbeComponent> spProbe = spObj->GetComponent<ProbeComponent>().lock()) sum += spProbe->hitCount + 1;
+            }
+            return sum;
+        });
+    Report("WeakPtr copy",objectCount,repeatCount,[&]()
+        {
+            long sum = 0;
+            for(WeakPtr<ProbeComponent>& wpProbe : vProbes)
+            {
+                WeakPtr<ProbeComponent> wpCopy = wpProbe;
+                sum += wpCopy.expired() ? 0 : 1;
+            }
+            return sum;
+        });
+    Report("SharedPtr copy",objectCount,repeatCount,[&]()
+        {
+            long sum = 0;
+            for(SharedPtr<GameObject>& spObj : vObjects)
+            {
+                SharedPtr<GameObject> spCopy = spObj;
+                sum += spCopy->IsActive();
+            }
+            return sum;
+        });
+
+    ScopedMuteCout mute;
+    objectManager.ReleaseAllObjects();
+    vObjects.clear();
+    vProbes.clear();
+    return 0;
+}
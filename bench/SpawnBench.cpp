@@ -0,0 +1,94 @@
+﻿#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+#include "ObjectManager.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// 名前を登録しない SpawnObject と、名前を登録する CreateObject で、オブジェクトを大量に作成する時間と確保回数を比べる
+// CreateObject は同じ名前 ("E") を渡すので、番号付きの名前 (E1, E2, ...) の生成と登録も含まれる
+// 使い方: SpawnBench [作成数=100000] [繰り返し回数=10]
+
+// 確保した回数を数える (このベンチマークの実行ファイルだけで置き換える)
+static std::size_t g_allocationCount = 0;
+
+void* operator new(std::size_t a_size)
+{
+    ++g_allocationCount;
+    if(void* p = std::malloc(a_size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* a_p) noexcept
+{
+    std::free(a_p);
+}
+
+void operator delete(void* a_p,std::size_t) noexcept
+{
+    std::free(a_p);
+}
+
+namespace
+{
+    // 1回分の作成にかかった時間(ミリ秒)と、1オブジェクトあたりの確保回数
+    struct Result
+    {
+        double ms = 0.0;
+        double allocationsPerObject = 0.0;
+    };
+
+    // 新しい ObjectManager で a_spawn を a_count 回呼ぶのを a_repeat 回繰り返し、最も速かった回の結果を返す
+    template<typename SpawnFunc>
+    Result Measure(std::size_t a_count,std::size_t a_repeat,SpawnFunc a_spawn)
+    {
+        Result best;
+        best.ms = -1.0;
+        for(std::size_t r = 0; r < a_repeat; ++r)
+        {
+            ScopedMuteCout mute;
+            ObjectManager objectManager;
+            std::size_t countBegin = g_allocationCount;
+            double ms = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t i = 0; i < a_count; ++i)
+                    {
+                        a_spawn(objectManager);
+                    }
+                });
+            if(best.ms < 0.0 || ms < best.ms)
+            {
+                best.ms = ms;
+                best.allocationsPerObject = static_cast<double>(g_allocationCount - countBegin) / static_cast<double>(a_count);
+            }
+            objectManager.ReleaseAllObjects();
+        }
+        return best;
+    }
+}
+
+int main(int argc,char** argv)
+{
+    std::size_t count = GetArgOr(argc,argv,1,100000);
+    std::size_t repeat = GetArgOr(argc,argv,2,10);
+
+    Result named = Measure(count,repeat,[](ObjectManager& a_objectManager)
+        {
+            a_objectManager.CreateObject("E");
+        });
+    Result unnamed = Measure(count,repeat,[](ObjectManager& a_objectManager)
+        {
+            a_objectManager.SpawnObject();
+        });
+
+    std::cout << count << " objects (best of " << repeat << ")" << std::endl;
+    std::cout << "  CreateObject(\"E\"): " << named.ms << " ms, " << named.allocationsPerObject << " allocs per object" << std::endl;
+    std::cout << "  SpawnObject():     " << unnamed.ms << " ms, " << unnamed.allocationsPerObject << " allocs per object" << std::endl;
+    std::cout << "  ratio: " << named.ms / unnamed.ms << "x" << std::endl;
+    return 0;
+}
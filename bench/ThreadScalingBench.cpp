@@ -0,0 +1,56 @@
+﻿#include <thread>
+#include <algorithm>
+
+#include "ObjectManager.hpp"
+#include "SampleComponents.hpp"
+#include "BenchCommon.hpp"
+
+
+
+// SetUpdateThreadCount で更新に使うスレッドを 1, 2, 4, ... と増やし、1フレームの時間を比べる
+// TransformComponent は THREAD_SAFE を宣言しているので、OnUpdate がプールの範囲ごとに各スレッドへ分けられる
+// 使い方: ThreadScalingBench [オブジェクト数=200000] [フレーム数=100] [最大スレッド数=コア数]
+// 確かめること (user-009): スレッド数を増やすと、コア数までは1フレームの時間が短くなる
+// 参考 (1コア・Release・既定の引数): 1スレッド 7.7 ms。1コアでは増やしても速くならないため、2コア以上での伸びは未計測
+int main(int argc,char** argv)
+{
+    std::size_t objectCount = GetArgOr(argc,argv,1,200000);
+    std::size_t frameCount = GetArgOr(argc,argv,2,100);
+    std::size_t maxThreadCount = GetArgOr(argc,argv,3,std::max(1u,std::thread::hardware_concurrency()));
+
+    std::cout << "objects: " << objectCount << ", frames: " << frameCount
+        << ", hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    double baseMs = 0.0;
+    for(std::size_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+    {
+        double frameMs = 0.0;
+        {
+            ScopedMuteCout mute;
+            ObjectManager objectManager;
+            objectManager.SetUpdateThreadCount(threadCount);
+            for(std::size_t i = 0; i < objectCount; ++i)
+            {
+                GameObject* pObj = objectManager.Resolve(objectManager.SpawnObject());
+                pObj->AddComponent<TransformComponent>(static_cast<float>(i),0.0f);
+            }
+            // 1フレーム目は OnStart を呼ぶので計測しない
+            objectManager.UpdateWorld(0.016f);
+
+            frameMs = MeasureMilliseconds([&]()
+                {
+                    for(std::size_t f = 0; f < frameCount; ++f)
+                    {
+                        objectManager.UpdateWorld(0.016f);
+                    }
+                }) / static_cast<double>(frameCount);
+            objectManager.ReleaseAllObjects();
+        }
+        if(threadCount == 1)
+        {
+            baseMs = frameMs;
+        }
+        std::cout << "threads " << threadCount << ": " << frameMs << " ms/frame (x" << baseMs / frameMs << ")" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+﻿#include <string>
+#include <string_view>
+
+#include "ObjectManager.hpp"
+#include "TestCheck.hpp"
+
+
+
+// 名前による検索に、終端文字の無い string_view (大きな文字列の一部) を渡しても正しく引けるかを確かめる
+// 以前は a_name.data() を渡していたため、切り出した範囲の後ろまで名前として読んでいた
+
+namespace
+{
+    struct Health : ComponentBase {};
+    struct Armor : ComponentBase {};
+
+    // 1つの文字列から名前を切り出す ("Player" の直後に "Enemy" が続き、どの範囲も終端文字で終わらない)
+    const std::string g_buffer = "PlayerEnemyHealthArmorPlayer2";
+    const std::string_view g_player(g_buffer.data(),6);
+    const std::string_view g_enemy(g_buffer.data() + 6,5);
+    const std::string_view g_health(g_buffer.data() + 11,6);
+    const std::string_view g_armor(g_buffer.data() + 17,5);
+    const std::string_view g_playerPrefix(g_buffer.data(),4); // "Play"
+
+    // オブジェクトの名前を切り出した範囲で登録し、切り出した範囲で探す
+    void TestObjectNames()
+    {
+        ObjectManager objectManager;
+
+        ObjectHandle player = objectManager.CreateObject(g_player);
+        ObjectHandle enemy = objectManager.CreateObject(g_enemy);
+
+        // 登録された名前は範囲の分だけで、後ろの文字を含まない
+        TEST_CHECK(objectManager.Resolve(player)->GetName() == "Player");
+        TEST_CHECK(objectManager.Resolve(enemy)->GetName() == "Enemy");
+
+        TEST_CHECK(objectManager.FindObject(g_player) == player);
+        TEST_CHECK(objectManager.FindObject(g_enemy) == enemy);
+        TEST_CHECK(!objectManager.GetObject(g_player).expired());
+
+        // 一部だけ一致する名前や、範囲を伸ばした名前では見つからない
+        TEST_CHECK(objectManager.FindObject(g_playerPrefix).IsNull());
+        TEST_CHECK(objectManager.FindObject(std::string_view(g_buffer.data(),11)).IsNull());
+
+        // 同じ名前を切り出した範囲で登録すると番号が付き、番号付きの名前も範囲で探せる
+        ObjectHandle player1 = objectManager.CreateObject(g_player);
+        TEST_CHECK(objectManager.Resolve(player1)->GetName() == "Player1");
+        TEST_CHECK(objectManager.FindObject(std::string_view(g_buffer.data() + 22,6)) == player);
+
+        // キーを一度取得しておけば、同じ結果を文字列を辿らずに引ける
+        NameKey playerKey = objectManager.InternName(g_player);
+        TEST_CHECK(objectManager.FindObject(playerKey) == player);
+
+        objectManager.ReleaseAllObjects();
+    }
+
+    // コンポーネントの名前を切り出した範囲で登録し、切り出した範囲で取得/削除する
+    void TestComponentNames()
+    {
+        ObjectManager objectManager;
+        SharedPtr<GameObject> spObject = objectManager.GenerateObject("Owner");
+
+        SharedPtr<ComponentBase> spHealth = MakeShared<Health>();
+        spObject->AddComponent(spHealth,g_health);
+        spObject->AddComponent(MakeShared<Armor>(),g_armor);
+
+        TEST_CHECK(spObject->GetComponent(g_health).lock() == spHealth);
+        TEST_CHECK(spObject->GetComponent(std::string("Health")).lock() == spHealth);
+        TEST_CHECK(!spObject->GetComponent(g_armor).expired());
+
+        // 一部だけ一致する名前では見つからず、削除もされない
+        TEST_CHECK(spObject->GetComponent(std::string_view(g_health.data(),4)).expired());
+        spObject->RemoveComponent(std::string_view(g_health.data(),4));
+        TEST_CHECK(!spObject->GetComponent(g_health).expired());
+
+        spObject->RemoveComponent(g_health);
+        TEST_CHECK(spObject->GetComponent(g_health).expired());
+        TEST_CHECK(!spObject->GetComponent(g_armor).expired());
+
+        objectManager.ReleaseAllObjects();
+    }
+}
+
+int main()
+{
+    TestObjectNames();
+    TestComponentNames();
+
+    if(GetTestFailureCount() != 0)
+    {
+        std::cerr << GetTestFailureCount() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "NameLookupTest passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,79 @@
+﻿#include <string>
+#include <vector>
+
+#include "ObjectManager.hpp"
+#include "TestCheck.hpp"
+
+
+
+// 同じ名前から番号付きの名前を作るときに、直接指定された番号付きの名前 (例: "E1") と重なる場合を確かめる
+// 重なった番号は空いた番号に戻さないので、次の作成で同じ番号を調べ直さない
+
+namespace
+{
+    // 番号付きの名前が先に直接登録されていても、重ならない番号が付く
+    void TestSkipPreExistingNames()
+    {
+        ObjectManager objectManager;
+
+        std::vector<ObjectHandle> vReserved;
+        for(int i = 1; i <= 3; ++i)
+        {
+            vReserved.push_back(objectManager.CreateObject("E" + std::to_string(i)));
+        }
+
+        std::vector<ObjectHandle> vCreated;
+        for(int i = 0; i < 3; ++i)
+        {
+            vCreated.push_back(objectManager.CreateObject("E"));
+        }
+        TEST_CHECK(objectManager.Resolve(vCreated[0])->GetName() == "E");
+        TEST_CHECK(objectManager.Resolve(vCreated[1])->GetName() == "E4");
+        TEST_CHECK(objectManager.Resolve(vCreated[2])->GetName() == "E5");
+
+        // 空いた番号は再利用されるが、飛ばした番号 (1～3) は戻らない
+        objectManager.Resolve(vCreated[1])->SetActive(false);
+        objectManager.UpdateWorld(0.016f);
+        ObjectHandle reused = objectManager.CreateObject("E");
+        TEST_CHECK(objectManager.Resolve(reused)->GetName() == "E4");
+        ObjectHandle next = objectManager.CreateObject("E");
+        TEST_CHECK(objectManager.Resolve(next)->GetName() == "E6");
+
+        objectManager.ReleaseAllObjects();
+    }
+
+    // "E" から作った名前が全て使われなくなったら、次は番号無しの名前から数え直す
+    void TestCounterResetAfterSkip()
+    {
+        ObjectManager objectManager;
+
+        ObjectHandle reserved = objectManager.CreateObject("E1");
+        ObjectHandle first = objectManager.CreateObject("E");
+        ObjectHandle second = objectManager.CreateObject("E");
+        TEST_CHECK(objectManager.Resolve(second)->GetName() == "E2");
+
+        objectManager.Resolve(first)->SetActive(false);
+        objectManager.Resolve(second)->SetActive(false);
+        objectManager.UpdateWorld(0.016f);
+
+        ObjectHandle recreated = objectManager.CreateObject("E");
+        TEST_CHECK(objectManager.Resolve(recreated)->GetName() == "E");
+        TEST_CHECK(objectManager.FindObject("E1") == reserved);
+
+        objectManager.ReleaseAllObjects();
+    }
+}
+
+int main()
+{
+    TestSkipPreExistingNames();
+    TestCounterResetAfterSkip();
+
+    if(GetTestFailureCount() != 0)
+    {
+        std::cerr << GetTestFailureCount() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "NameSuffixTest passed" << std::endl;
+    return 0;
+}
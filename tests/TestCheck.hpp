@@ -0,0 +1,26 @@
+﻿#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <iostream>
+
+
+
+// 失敗した条件の数 (main の戻り値にする)
+inline int& GetTestFailureCount()
+{
+    static int s_failureCount = 0;
+    return s_failureCount;
+}
+
+// 条件が偽なら場所と式を表示し、失敗として数える (assert と違い NDEBUG でも消えない)
+#define TEST_CHECK(expr)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if(!(expr))                                                                             \
+        {                                                                                       \
+            std::cerr << __FILE__ << "(" << __LINE__ << "): TEST_CHECK(" #expr ") failed" << std::endl; \
+            ++GetTestFailureCount();                                                            \
+        }                                                                                       \
+    } while(false)
+
+#endif // TEST_CHECK_HPP